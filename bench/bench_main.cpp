@@ -0,0 +1,484 @@
+#include "../include/game.h"
+#include "../include/pair_kernel.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <new>
+#include <vector>
+
+// Every heap allocation in the process, for the steady-state check
+std::atomic<uint64_t> heapAllocations{0};
+
+void* operator new(std::size_t size) {
+    heapAllocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+
+void* operator new(std::size_t size, std::align_val_t align) {
+    heapAllocations.fetch_add(1, std::memory_order_relaxed);
+    size_t alignment = static_cast<size_t>(align);
+    // aligned_alloc wants a multiple of the alignment
+    if (void* p = std::aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment)) return p;
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size) { return operator new(size); }
+void* operator new[](std::size_t size, std::align_val_t align) { return operator new(size, align); }
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete(void* p, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t, std::align_val_t) noexcept { std::free(p); }
+
+// Drives Game's private hot paths directly (Game befriends this class)
+class GameBench {
+public:
+    static void initialize(Game& game) {
+        game.verbose_ = false;
+        game.initializeNPCs();
+    }
+
+    static World& world(Game& game) { return game.world_; }
+
+    static size_t moveAll(Game& game) { return game.moveAll(); }
+
+    // Nothing consumes the queue outside run(), so drain it here and mark
+    // the events resolved so the next pass is not deduplicated away
+    static size_t detectCombats(Game& game) {
+        game.detectCombats();
+        CombatEvent drained[1024];
+        size_t pairs = 0;
+        size_t position = 0;
+        while (size_t count = game.combatQueue_.popBatch(drained, 1024, &position)) {
+            pairs += count;
+            game.resolvedPosition_.store(position + count);
+        }
+        return pairs;
+    }
+
+    static std::vector<CombatPair> pairs(Game& game) {
+        return game.findCombatPairs(DetectionMode::Grid);
+    }
+
+    static bool processCombat(Game& game, const CombatEvent& event, uint64_t serial) {
+        return game.processCombat(event, serial);
+    }
+
+    static void printMap(Game& game) { game.printMap(); }
+
+    // Everything the game does per headless tick: simulate, log, publish, render
+    static void tick(Game& game) {
+        game.headlessTick();
+        game.snapshots_.publish(game.world_, game.tick_.load(), game.mapSize_);
+        game.printMap();
+    }
+
+    // The interactive path as run() drives it: a combat thread drains the
+    // queue while ticks detect, dedup and publish combats
+    static void startCombatThread(Game& game) {
+        game.running_ = true;
+        game.combatQueue_.reopen();
+        game.combatThread_ = std::thread(&Game::combatThread, &game);
+    }
+
+    static void interactiveTick(Game& game) {
+        game.simulateTick();
+        game.printMap();
+    }
+
+    static void stopCombatThread(Game& game) {
+        game.running_ = false;
+        game.combatQueue_.close();
+        game.combatThread_.join();
+    }
+
+    static void startLog(Game& game) {
+        game.eventLog_.start(LogLevel::Combat, LogFormat::Text, "");
+    }
+
+    static void stopLog(Game& game) { game.eventLog_.stop(); }
+};
+
+namespace {
+
+struct Options {
+    std::string filter;
+    uint64_t seed = 42;
+    unsigned threads = 0;
+    double minSeconds = 0.1;
+    size_t maxNpcs = 1000000;
+    bool json = false;
+    bool checkAllocations = false;
+    bool help = false;
+    DetectionMode detection = DetectionMode::Sharded;
+};
+
+struct Case {
+    std::string op;
+    int npcs;
+    int mapSize;
+};
+
+struct Result {
+    uint64_t iterations = 0;
+    uint64_t items = 0;   // work items processed across all iterations
+    double seconds = 0.0;
+    std::string skipped;
+};
+
+// Keeps the compiler from discarding results of pure calls
+volatile long long benchSink = 0;
+
+const int kNpcCounts[] = {50, 1000, 10000, 100000, 1000000};
+const int kMapSizes[] = {100, 1000, 10000, 100000};
+
+// Rough expected pair count per detection pass; the pair list for dense
+// worlds alone would not fit in memory
+double expectedPairs(int npcs, int mapSize) {
+    double density = static_cast<double>(npcs) / (static_cast<double>(mapSize) * mapSize);
+    return 0.5 * npcs * density * 3.14159 * 10 * 10;
+}
+
+using Clock = std::chrono::steady_clock;
+
+// Repeats op in doubling batches until minSeconds of measured time;
+// op returns the number of items it processed and may exclude its own
+// setup by adding to untimed. Untimed setup is capped at 10x minSeconds.
+template <typename Op>
+Result measure(double minSeconds, Op op) {
+    Result result;
+    uint64_t batch = 1;
+    double wall = 0.0;
+
+    while (result.seconds < minSeconds && wall < 10 * minSeconds) {
+        double untimed = 0.0;
+        auto start = Clock::now();
+        for (uint64_t i = 0; i < batch; ++i) {
+            result.items += op(untimed);
+        }
+        double elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+
+        wall += elapsed;
+        result.seconds += std::max(0.0, elapsed - untimed);
+        result.iterations += batch;
+        batch *= 2;
+    }
+    return result;
+}
+
+double elapsedSince(Clock::time_point start) {
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+Result runCase(const Case& c, const Options& options) {
+    Result skipped;
+
+    if (c.op == "detectCombats" || c.op == "processCombat") {
+        if (expectedPairs(c.npcs, c.mapSize) > 2e7) {
+            skipped.skipped = "too dense";
+            return skipped;
+        }
+    }
+
+    GameConfig config;
+    config.mapSize = c.mapSize;
+    config.npcCount = c.npcs;
+    config.threads = options.threads;
+    config.seed = options.seed;
+
+    Game game(config);
+    game.setDetectionMode(options.detection);
+    GameBench::initialize(game);
+    World& world = GameBench::world(game);
+
+    if (c.op == "moveNPC") {
+        return measure(options.minSeconds, [&](double&) {
+            return GameBench::moveAll(game);
+        });
+    }
+
+    if (c.op == "detectCombats") {
+        return measure(options.minSeconds, [&](double&) {
+            GameBench::detectCombats(game);
+            return static_cast<size_t>(1);
+        });
+    }
+
+    if (c.op == "processCombat") {
+        std::vector<CombatEvent> events;
+        size_t next = 0;
+        auto refill = [&] {
+            // Fresh world with the same seed so every event starts with both alive
+            GameBench::initialize(game);
+            events.clear();
+            for (const auto& pair : GameBench::pairs(game)) {
+                events.push_back({pair.first, pair.second});
+            }
+            if (events.empty()) {
+                events.push_back({0, std::min<World::Index>(1, world.size() - 1)});
+            }
+            next = 0;
+        };
+        refill();
+
+        return measure(options.minSeconds, [&](double& untimed) {
+            if (next == events.size()) {
+                auto start = Clock::now();
+                refill();
+                untimed += elapsedSince(start);
+            }
+            GameBench::processCombat(game, events[next], next);
+            ++next;
+            return static_cast<size_t>(1);
+        });
+    }
+
+    if (c.op == "distanceSquaredTo" || c.op == "rollDice") {
+        std::vector<NPCPtr> handles;
+        for (World::Index i = 0; i < std::min<size_t>(world.size(), 1024); ++i) {
+            handles.push_back(world.npc(i));
+        }
+        size_t next = 0;
+
+        return measure(options.minSeconds, [&](double&) {
+            const NPC& a = *handles[next % handles.size()];
+            const NPC& b = *handles[(next * 7 + 3) % handles.size()];
+            ++next;
+            benchSink = c.op == "rollDice" ? a.rollDice(options.seed, next) : a.distanceSquaredTo(b);
+            return static_cast<size_t>(1);
+        });
+    }
+
+    if (c.op == "printMap") {
+        std::ostringstream discard;
+        std::streambuf* original = std::cout.rdbuf(discard.rdbuf());
+        Result result = measure(options.minSeconds, [&](double& untimed) {
+            GameBench::printMap(game);
+            auto start = Clock::now();
+            discard.str(std::string());
+            untimed += elapsedSince(start);
+            return static_cast<size_t>(1);
+        });
+        std::cout.rdbuf(original);
+        return result;
+    }
+
+    throw std::invalid_argument("unknown benchmark '" + c.op + "'");
+}
+
+void selectKernel(const std::string& name) {
+    for (PairKernel kernel : {PairKernel::Scalar, PairKernel::Sse41, PairKernel::Avx2, PairKernel::Avx512}) {
+        if (name != pairKernelName(kernel)) continue;
+        if (!selectPairKernel(kernel)) throw std::invalid_argument("CPU does not support kernel '" + name + "'");
+        return;
+    }
+    throw std::invalid_argument("--kernel expects scalar, sse4.1, avx2 or avx512");
+}
+
+DetectionMode parseDetection(const std::string& name) {
+    if (name == "grid") return DetectionMode::Grid;
+    if (name == "sharded") return DetectionMode::Sharded;
+    if (name == "brute") return DetectionMode::BruteForce;
+    throw std::invalid_argument("--detection expects grid, sharded or brute");
+}
+
+void printUsage(const char* program) {
+    std::cout << "Usage: " << program << " [--filter TEXT] [--seed N] [--threads N] [--min-time SECONDS]\n"
+              << "       [--max-npcs N] [--kernel scalar|sse4.1|avx2|avx512]\n"
+              << "       [--detection grid|sharded|brute] [--json]\n"
+              << "       " << program << " --check-allocs [--seed N] [--threads N]\n\n"
+              << "  --filter        only run cases whose name contains TEXT\n"
+              << "  --json          print results as JSON\n"
+              << "  --check-allocs  run headless and interactive ticks after a warm-up and\n"
+              << "                  exit with status 1 if any of them allocates\n";
+}
+
+Options parseOptions(int argc, char* argv[]) {
+    Options options;
+    for (int i = 1; i < argc; ++i) {
+        std::string flag = argv[i];
+        if (flag == "--help" || flag == "-h") {
+            options.help = true;
+            continue;
+        }
+        if (flag == "--json") {
+            options.json = true;
+            continue;
+        }
+        if (flag == "--check-allocs") {
+            options.checkAllocations = true;
+            continue;
+        }
+        if (i + 1 >= argc) throw std::invalid_argument(flag + " expects a value");
+        std::string value = argv[++i];
+
+        if (flag == "--filter") options.filter = value;
+        else if (flag == "--seed") options.seed = std::stoull(value);
+        else if (flag == "--threads") options.threads = static_cast<unsigned>(std::stoul(value));
+        else if (flag == "--min-time") options.minSeconds = std::stod(value);
+        else if (flag == "--max-npcs") options.maxNpcs = std::stoull(value);
+        else if (flag == "--kernel") selectKernel(value);
+        else if (flag == "--detection") options.detection = parseDetection(value);
+        else throw std::invalid_argument("unknown option '" + flag + "'");
+    }
+    return options;
+}
+
+// Swallows console output without buffering it
+class NullBuffer : public std::streambuf {
+protected:
+    int overflow(int c) override { return c; }
+    std::streamsize xsputn(const char*, std::streamsize count) override { return count; }
+};
+
+// Runs full ticks (with combat logging and map printing) until buffers
+// have grown to their working size, then requires that further ticks
+// make no heap allocations at all. Covers both the headless tick and the
+// interactive one (publish, pair dedup, combat thread). Returns the
+// allocations seen.
+uint64_t checkSteadyStateAllocations(const Options& options) {
+    const int warmupTicks = 100;
+    const int measuredTicks = 200;
+
+    GameConfig config;
+    config.mapSize = 1000;
+    config.npcCount = 20000;
+    config.threads = options.threads;
+    config.combatThreads = 2;
+    config.seed = options.seed;
+
+    NullBuffer discard;
+    std::streambuf* original = std::cout.rdbuf(&discard);
+
+    uint64_t headless = 0;
+    {
+        Game game(config);
+        GameBench::initialize(game);
+        GameBench::startLog(game);
+        for (int t = 0; t < warmupTicks; ++t) GameBench::tick(game);
+
+        uint64_t before = heapAllocations.load();
+        for (int t = 0; t < measuredTicks; ++t) GameBench::tick(game);
+        headless = heapAllocations.load() - before;
+
+        GameBench::stopLog(game);
+    }
+
+    uint64_t interactive = 0;
+    {
+        Game game(config);
+        GameBench::initialize(game);
+        GameBench::startLog(game);
+        GameBench::startCombatThread(game);
+        for (int t = 0; t < warmupTicks; ++t) GameBench::interactiveTick(game);
+
+        uint64_t before = heapAllocations.load();
+        for (int t = 0; t < measuredTicks; ++t) GameBench::interactiveTick(game);
+        interactive = heapAllocations.load() - before;
+
+        GameBench::stopCombatThread(game);
+        GameBench::stopLog(game);
+    }
+
+    std::cout.rdbuf(original);
+
+    std::cout << "steady state (" << config.npcCount << " NPCs, " << config.mapSize
+              << " map, seed " << options.seed << ", " << measuredTicks << " ticks each):\n"
+              << "  headless:    " << headless << " heap allocations\n"
+              << "  interactive: " << interactive << " heap allocations\n";
+    return headless + interactive;
+}
+
+void report(const Case& c, const Result& r, const Options& options, bool& first) {
+    std::string name = c.op + "/npcs:" + std::to_string(c.npcs) + "/map:" + std::to_string(c.mapSize);
+    double nsPerOp = r.iterations ? r.seconds * 1e9 / r.iterations : 0.0;
+    double opsPerSec = r.seconds > 0.0 ? r.iterations / r.seconds : 0.0;
+    double itemsPerSec = r.seconds > 0.0 ? r.items / r.seconds : 0.0;
+
+    if (options.json) {
+        std::cout << (first ? "  " : ",\n  ") << "{\"name\": \"" << name << "\""
+                  << ", \"op\": \"" << c.op << "\", \"npcs\": " << c.npcs
+                  << ", \"map_size\": " << c.mapSize;
+        if (!r.skipped.empty()) {
+            std::cout << ", \"skipped\": \"" << r.skipped << "\"}";
+        } else {
+            std::cout << ", \"iterations\": " << r.iterations
+                      << ", \"ns_per_op\": " << nsPerOp
+                      << ", \"ops_per_sec\": " << opsPerSec
+                      << ", \"items_per_sec\": " << itemsPerSec << "}";
+        }
+        first = false;
+        return;
+    }
+
+    std::cout << std::left << std::setw(44) << name << std::right;
+    if (!r.skipped.empty()) {
+        std::cout << "  skipped (" << r.skipped << ")\n";
+        return;
+    }
+    std::cout << std::setw(12) << r.iterations
+              << std::setw(16) << std::fixed << std::setprecision(1) << nsPerOp << " ns/op"
+              << std::setw(16) << std::setprecision(0) << opsPerSec << " op/s";
+    if (r.items != r.iterations) {
+        std::cout << std::setw(16) << itemsPerSec << " items/s";
+    }
+    std::cout << std::defaultfloat << '\n';
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    try {
+        Options options = parseOptions(argc, argv);
+        if (options.help) {
+            printUsage(argv[0]);
+            return 0;
+        }
+        if (options.checkAllocations) {
+            return checkSteadyStateAllocations(options) == 0 ? 0 : 1;
+        }
+
+        const char* ops[] = {"moveNPC", "detectCombats", "processCombat",
+                             "distanceSquaredTo", "rollDice", "printMap"};
+
+        bool first = true;
+        if (options.json) {
+            std::cout << "{\"seed\": " << options.seed
+                      << ", \"pair_kernel\": \"" << pairKernelName(activePairKernel()) << "\""
+                      << ", \"benchmarks\": [\n";
+        } else {
+            std::cout << "seed " << options.seed << ", min time " << options.minSeconds << " s"
+                      << ", pair kernel " << pairKernelName(activePairKernel()) << "\n";
+        }
+
+        for (const char* op : ops) {
+            for (int npcs : kNpcCounts) {
+                if (static_cast<size_t>(npcs) > options.maxNpcs) continue;
+                for (int mapSize : kMapSizes) {
+                    Case c{op, npcs, mapSize};
+                    std::string name = c.op + "/npcs:" + std::to_string(npcs) + "/map:" + std::to_string(mapSize);
+                    if (name.find(options.filter) == std::string::npos) continue;
+
+                    report(c, runCase(c, options), options, first);
+                }
+            }
+        }
+
+        if (options.json) std::cout << "\n]}\n";
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include "game.h"
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+struct BatchConfig {
+    uint64_t games = 1000;
+    uint64_t seed = 1;      // game g plays with a seed drawn from (seed, g)
+    unsigned workers = 0;   // 0 = all cores; each worker plays whole games
+    int mapSize = 100;
+    int npcCount = 50;
+    int maxTicks = 1000;    // per game; games also end once at most one NPC is left
+};
+
+// Totals over every game of a batch. All fields are sums or counts, so the
+// summary is the same for any number of workers.
+struct BatchSummary {
+    static constexpr size_t kTypes = GameOutcome::kTypes;
+
+    uint64_t games = 0;
+    uint64_t ticks = 0;
+    double seconds = 0.0;
+
+    std::array<uint64_t, kTypes> survivors{};        // summed over games
+    std::array<uint64_t, kTypes> gamesSurvived{};    // games with at least one left
+    std::array<uint64_t, kTypes * kTypes> kills{};   // [attacker type][defender type]
+    // extinctions[t][tick]: games in which type t was wiped out on that tick
+    std::array<std::vector<uint64_t>, kTypes> extinctions;
+
+    void add(const GameOutcome& outcome);
+    void merge(const BatchSummary& other);
+
+    uint64_t extinctionCount(size_t type) const;
+    double meanExtinctionTick(size_t type) const;
+    // Tick by which a fraction q of the type's extinctions had happened
+    int extinctionPercentile(size_t type, double q) const;
+};
+
+// Monte Carlo driver: plays config.games independent headless games across
+// worker threads. Every worker keeps one single-threaded Game and replays
+// it with a new seed per game (Game::playOut), so world, grid and combat
+// buffers are allocated once per worker, not once per game. Nothing is
+// printed per game; outcomes go straight into per-worker summaries that
+// are merged at the end.
+class BatchRunner {
+public:
+    // Throws std::invalid_argument for an invalid map size, NPC count or tick limit
+    explicit BatchRunner(const BatchConfig& config);
+
+    BatchSummary run();
+
+    // Seed game g plays with; never 0, which Game reads as "random"
+    static uint64_t gameSeed(uint64_t batchSeed, uint64_t game);
+
+private:
+    void work(std::atomic<uint64_t>& next, BatchSummary& summary);
+
+    BatchConfig config_;
+};
@@ -0,0 +1,95 @@
+#pragma once
+
+#include "thread_pool.h"
+#include "world.h"
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Everything besides the world store needed to resume a run. Random draws
+// are keyed by (seed, tick, NPC) or (seed, combat serial), so these
+// counters are the whole generator state.
+struct CheckpointState {
+    uint64_t seed = 0;
+    uint64_t tick = 0;
+    uint64_t combatSerial = 0;   // dice stream of the next combat, headless or not
+    uint64_t combatsResolved = 0;
+    uint64_t kills = 0;
+    int mapSize = 0;
+};
+
+// Checkpoint file, native byte order, written by one build and read back by
+// the same: the header, then count packed positions (World::pack), count
+// type bytes and count alive bytes. The position array starts 8-byte
+// aligned, so a mapped file is read in place.
+struct CheckpointHeader {
+    char magic[8];        // "L7CKPT\0\1"
+    uint32_t version;
+    uint32_t headerSize;  // sizeof(CheckpointHeader)
+    uint64_t count;
+    uint64_t seed;
+    uint64_t tick;
+    uint64_t combatSerial;
+    uint64_t combatsResolved;
+    uint64_t kills;
+    int32_t mapSize;
+    uint32_t typeCount;
+};
+
+static_assert(sizeof(CheckpointHeader) % 8 == 0, "positions must stay 8-byte aligned");
+
+// Maps the file and fills world from it with one parallel pass; throws
+// std::runtime_error if the file is missing, truncated or from another
+// format version.
+CheckpointState loadCheckpoint(const std::string& path, World& world, ThreadPool& pool);
+
+// Background checkpoint writer.
+// submit() copies the world on the calling thread (a linear pass, no I/O);
+// the writer thread then saves it to "<path>.tmp", syncs it and renames it
+// over path, so a crash mid-write leaves the previous checkpoint intact.
+class CheckpointWriter {
+public:
+    CheckpointWriter() = default;
+    ~CheckpointWriter();
+
+    CheckpointWriter(const CheckpointWriter&) = delete;
+    CheckpointWriter& operator=(const CheckpointWriter&) = delete;
+
+    // Throws if "<path>.tmp" cannot be created
+    void start(const std::string& path);
+    // Finishes the write in progress and joins the writer thread
+    void stop();
+
+    // Returns false, copying nothing, while the previous checkpoint is still
+    // being written; with wait set it blocks until the writer is free instead
+    bool submit(const World& world, const CheckpointState& state, bool wait = false);
+
+    uint64_t written() const { return written_.load(std::memory_order_relaxed); }
+    uint64_t skipped() const { return skipped_.load(std::memory_order_relaxed); }
+    // Reason the last write failed, empty if none has
+    std::string lastError() const;
+
+private:
+    void writeLoop();
+    void writeFile();
+
+    std::string path_;
+    CheckpointHeader header_{};
+    std::vector<uint64_t> positions_;
+    std::vector<uint8_t> types_;
+    std::vector<uint8_t> alive_;
+
+    std::atomic<uint64_t> written_{0};
+    std::atomic<uint64_t> skipped_{0};
+    std::string error_;
+
+    std::thread thread_;
+    mutable std::mutex mutex_;
+    std::condition_variable cv_;
+    bool pending_ = false;    // buffers hold a checkpoint not yet written
+    bool stopping_ = false;
+};
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+
+// Compact, trivially copyable combat event: two indices into the World store
+struct CombatEvent {
+    uint32_t attacker;
+    uint32_t defender;
+};
+
+// What detectCombats does when the ring has no room for a tick's events
+enum class OverflowPolicy {
+    Block,       // producer waits for the combat thread to catch up
+    DropOldest,  // evict the oldest queued events to make room
+    Coalesce     // hold the overflow; next tick's detection supersedes it
+};
+
+// Producer-side counters; queued is the ring depth when sampled
+struct CombatQueueStats {
+    uint64_t published = 0;
+    uint64_t deduplicated = 0;  // pair already queued and not yet resolved
+    uint64_t dropped = 0;       // evicted, or held overflow no longer in range
+    uint64_t coalesced = 0;     // held overflow merged with a re-detected pair
+    size_t queued = 0;
+};
+
+// Bounded lock-free MPMC ring of combat events (Vyukov-style: each slot
+// carries a sequence number). Producers claim a run of free slots with a
+// single CAS and publish a whole tick's events at once; the consumer drains
+// runs the same way. The consumer only sleeps when the ring is empty, and a
+// producer touches the wake-up mutex at most once per batch, only when the
+// consumer is actually waiting.
+class CombatQueue {
+public:
+    // capacity is rounded up to a power of two
+    explicit CombatQueue(size_t capacity);
+
+    CombatQueue(const CombatQueue&) = delete;
+    CombatQueue& operator=(const CombatQueue&) = delete;
+
+    // Returns how many events were enqueued (fewer than count if full).
+    // Ring positions are monotonic; position receives the first one used.
+    size_t pushBatch(const CombatEvent* events, size_t count, size_t* position = nullptr);
+    size_t popBatch(CombatEvent* out, size_t maxCount, size_t* position = nullptr);
+
+    // Blocks until events are available; false once the queue is closed
+    bool wait();
+    void close();
+    void reopen();
+
+    bool empty() const;
+    size_t size() const;
+    size_t capacity() const { return mask_ + 1; }
+
+private:
+    struct Slot {
+        std::atomic<size_t> sequence;
+        CombatEvent event;
+    };
+
+    void wakeConsumer();
+
+    size_t mask_;
+    std::unique_ptr<Slot[]> slots_;
+
+    alignas(64) std::atomic<size_t> enqueuePos_{0};
+    alignas(64) std::atomic<size_t> dequeuePos_{0};
+
+    alignas(64) std::atomic<uint32_t> waiters_{0};
+    std::mutex waitMutex_;
+    std::condition_variable waitCV_;
+    bool closed_ = false;
+};
@@ -0,0 +1,59 @@
+#pragma once
+
+#include "philox.h"
+#include "combat_queue.h"
+#include "thread_pool.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Splits a batch of combat events into conflict-free rounds and resolves
+// each round in parallel. An event goes into the round after the latest
+// round holding either of its NPCs (greedy colouring in batch order), so
+// no NPC appears twice in a round and events sharing an NPC keep their
+// relative order. With per-event dice the result matches resolving the
+// batch serially, whatever the worker count.
+class CombatResolver {
+public:
+    // resolveOne(const CombatEvent& event, size_t indexInBatch)
+    template <typename F>
+    void resolve(const CombatEvent* events, size_t count, size_t npcCount,
+                 ThreadPool& pool, F&& resolveOne) {
+        schedule(events, count, npcCount);
+
+        for (size_t round = 0; round + 1 < roundStart_.size(); ++round) {
+            pool.parallelFor(roundStart_[round], roundStart_[round + 1], kRoundGrain,
+                [&](size_t begin, size_t end, unsigned) {
+                    for (size_t k = begin; k < end; ++k) {
+                        uint32_t i = order_[k];
+                        resolveOne(events[i], i);
+                    }
+                });
+        }
+    }
+
+    size_t lastRoundCount() const { return roundStart_.empty() ? 0 : roundStart_.size() - 1; }
+
+private:
+    static constexpr size_t kRoundGrain = 64;
+
+    void schedule(const CombatEvent* events, size_t count, size_t npcCount);
+
+    // Per-NPC latest round, valid only where stamp_ matches the batch
+    std::vector<uint32_t> lastRound_;
+    std::vector<uint32_t> stamp_;
+    uint32_t batch_ = 0;
+
+    std::vector<uint32_t> eventRound_;
+    std::vector<uint32_t> roundStart_;
+    std::vector<uint32_t> order_;
+};
+
+// Two d6 rolls (attack, defense) drawn from a stream identified by the
+// game seed and the event's sequence number, independent of the thread
+// that resolves it
+inline void combatRolls(uint64_t seed, uint64_t stream, int& attack, int& defense) {
+    Philox::Counter words = randomWords(seed, stream, 0, RngPurpose::Combat);
+    attack = 1 + static_cast<int>(uniformBelow(words[0], 6));
+    defense = 1 + static_cast<int>(uniformBelow(words[1], 6));
+}
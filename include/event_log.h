@@ -0,0 +1,111 @@
+#pragma once
+
+#include "profiler.h"
+#include "world.h"
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <fstream>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+enum class LogLevel {
+    Off,     // no combat records at all
+    Kills,   // only fights that ended in a kill
+    Combat   // every fight
+};
+
+enum class LogFormat {
+    Text,    // human-readable, to the console
+    Binary   // raw CombatRecords appended to a file
+};
+
+// Fixed-size binary record written on the combat hot path. The binary log
+// is a raw copy of these, so the tail padding is an explicit zero field and
+// no uninitialised bytes reach the file.
+struct CombatRecord {
+    uint64_t tick;
+    uint32_t attacker;
+    uint32_t defender;
+    uint8_t attackRoll;
+    uint8_t defenseRoll;
+    uint8_t killed;
+    uint8_t reserved;
+    uint32_t pad;
+};
+static_assert(sizeof(CombatRecord) == 24, "binary log records are 24 bytes with no implicit padding");
+
+// Asynchronous combat log.
+// Each writing thread gets its own single-producer ring, so logCombat is
+// a couple of stores with no lock and no allocation; a full ring drops
+// the record and counts it. A background thread drains all rings, orders
+// the records by tick and writes them as text or as a binary file.
+class EventLog {
+public:
+    // Text output goes to out, serialised with other console output by outMutex
+    EventLog(const World& world, std::ostream& out, std::mutex& outMutex, Profiler& profiler);
+    ~EventLog();
+
+    EventLog(const EventLog&) = delete;
+    EventLog& operator=(const EventLog&) = delete;
+
+    // binaryPath is only used with LogFormat::Binary
+    void start(LogLevel level, LogFormat format, const std::string& binaryPath = "");
+    // Drains everything logged so far and joins the background thread
+    void stop();
+
+    bool wants(bool killed) const {
+        LogLevel level = level_.load(std::memory_order_relaxed);
+        return level == LogLevel::Combat || (killed && level == LogLevel::Kills);
+    }
+
+    void logCombat(const CombatRecord& record);
+
+    uint64_t dropped() const { return dropped_.load(std::memory_order_relaxed); }
+
+private:
+    static constexpr size_t kRingSize = 4096;   // records per thread
+    static constexpr size_t kMaxRings = 256;
+
+    struct Ring {
+        std::array<CombatRecord, kRingSize> records;
+        alignas(64) std::atomic<size_t> head{0};   // written by the drain thread
+        alignas(64) std::atomic<size_t> tail{0};   // written by the owner thread
+        std::thread::id owner;
+    };
+
+    Ring* localRing();
+    void drainLoop();
+    size_t drainOnce();
+    void write(const std::vector<CombatRecord>& records);
+
+    const World& world_;
+    std::ostream& out_;
+    std::mutex& outMutex_;
+    Profiler& profiler_;
+    const uint64_t id_;
+
+    std::atomic<LogLevel> level_{LogLevel::Off};
+    LogFormat format_ = LogFormat::Text;
+    std::ofstream binary_;
+
+    // Rings are published once and live as long as the log
+    std::array<std::atomic<Ring*>, kMaxRings> rings_{};
+    std::atomic<size_t> ringCount_{0};
+    std::mutex registerMutex_;
+    std::atomic<uint64_t> dropped_{0};
+
+    std::vector<CombatRecord> pending_;
+    std::vector<uint32_t> order_;
+    std::vector<CombatRecord> sorted_;
+    std::string text_;
+
+    std::thread drainThread_;
+    std::mutex wakeMutex_;
+    std::condition_variable wakeCV_;
+    bool stopping_ = false;
+};
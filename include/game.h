@@ -1,52 +1,242 @@
 #pragma once
 
 #include "npc.h"
+#include "checkpoint.h"
+#include "combat_queue.h"
+#include "combat_resolver.h"
+#include "event_log.h"
+#include "map_renderer.h"
+#include "pair_set.h"
+#include "philox.h"
+#include "profiler.h"
+#include "region_shards.h"
+#include "scheduler.h"
+#include "snapshot_exchange.h"
+#include "spatial_grid.h"
+#include "thread_pool.h"
+#include "world.h"
 #include <vector>
 #include <thread>
 #include <mutex>
 #include <shared_mutex>
 #include <atomic>
-#include <queue>
-#include <condition_variable>
 
-struct CombatEvent {
-    NPCPtr attacker;
-    NPCPtr defender;
+// Pair search used by detectCombats. BruteForce is the O(n^2) reference
+// kept for verifying that Grid reports exactly the same pairs. Sharded
+// runs one grid per map strip (RegionShards) and reports the same pairs in
+// strip order. All test candidates in blocks with the vectorised rangeMask
+// kernel.
+enum class DetectionMode {
+    Grid,
+    Sharded,
+    BruteForce
 };
 
+struct GameConfig {
+    int mapSize = 100;
+    int npcCount = 50;
+    int duration = 30;      // seconds of wall-clock time in run()
+    unsigned threads = 0;   // movement/detection pool size, 0 = all cores
+    unsigned combatThreads = 1;
+    uint64_t seed = 0;      // keys every random draw; 0 draws one from random_device
+    size_t combatQueueCapacity = 1 << 16;
+    OverflowPolicy overflowPolicy = OverflowPolicy::Block;
+    LogLevel logLevel = LogLevel::Combat;
+    LogFormat logFormat = LogFormat::Text;
+    std::string logPath = "combat.log";   // binary format only
+    int viewportSize = 20;   // side of the centred map window printed each second
+    int heatmapSize = 0;     // columns of the whole-map heatmaps, 0 = off
+    bool profile = false;    // phase/lock/queue statistics, dumped periodically and at the end
+    int profileInterval = 5; // seconds between dumps in run()
+    std::string tracePath{}; // Chrome trace of ticks [traceStart, traceStart + traceTicks)
+    uint64_t traceStart = 1;
+    uint64_t traceTicks = 100;
+    std::string checkpointPath{};   // saved every checkpointEvery ticks and at the end
+    uint64_t checkpointEvery = 100;
+    std::string restorePath{};      // resume from this checkpoint instead of placing NPCs
+};
+
+// Throughput figures from runHeadless()
+struct HeadlessResult {
+    int ticks = 0;
+    double seconds = 0.0;
+    uint64_t npcUpdates = 0;
+    uint64_t combatsResolved = 0;
+    uint64_t kills = 0;
+    size_t survivors = 0;
+    uint64_t checksum = 0;   // of survivor ids and positions; equal for equal seeds
+};
+
+// Result of one Game::playOut()
+struct GameOutcome {
+    static constexpr size_t kTypes = NPC::kTypeCount;
+    
+    int ticks = 0;
+    std::array<uint32_t, kTypes> survivors{};
+    std::array<int, kTypes> extinctionTick{};           // -1 if never wiped out
+    std::array<uint32_t, kTypes * kTypes> kills{};      // [attacker type][defender type]
+};
+
+// Indices into the world store, attacker first, attacker < defender
+using CombatPair = std::pair<World::Index, World::Index>;
+
 class Game {
 public:
-    Game(int mapSize, int npcCount, int duration);
+    explicit Game(const GameConfig& config);
+    Game(int mapSize, int npcCount, int duration, unsigned threads = 0);
     ~Game();
 
     void run();
+    
+    // Runs ticks back-to-back on the calling thread: no sleeps, no console
+    // output, combats resolved inline at the end of each tick
+    HeadlessResult runHeadless(int ticks);
+    // Plays one quiet headless game with a fresh placement from seed, until
+    // at most one NPC is left or maxTicks have run. Reuses every buffer of
+    // the previous game, so a worker can play many games on one Game.
+    GameOutcome playOut(uint64_t seed, int maxTicks);
+
+    // Restoring a checkpoint replaces the configured seed, map and NPC count
+    uint64_t seed() const { return seed_; }
+    int mapSize() const { return mapSize_; }
+    int npcCount() const { return npcCount_; }
+    
+    // Latest world state published at a tick boundary; safe to hold from any
+    // thread while the simulation keeps running
+    SnapshotExchange::Reader snapshot() const { return snapshots_.acquire(); }
+    CombatQueueStats combatQueueStats() const;
+    void setDetectionMode(DetectionMode mode) { detectionMode_ = mode; }
+    
+    // Pairs currently in combat range, sorted by attacker then defender
+    std::vector<CombatPair> findCombatPairs(DetectionMode mode);
 
 private:
+    friend class GameBench;
+    
     void initializeNPCs();
-    void movementThread();
+    void placeNPCs();
+    void restoreNPCs();
+    // Hands the world to the checkpoint writer if one is due at this tick
+    void saveCheckpoint(uint64_t tick, bool final);
+    // Waits until the combat thread has resolved everything published so far
+    void drainCombats();
+    uint64_t nextCombatSerial() const;
+    // One interactive tick: move the given types, detect and publish
+    // combats, snapshot
+    void simulateTick(uint32_t types = kAllTypes);
     void combatThread();
-    void printThread();
     
-    void moveNPC(NPCPtr npc);
+    // One runHeadless tick: move, detect, resolve inline; returns NPCs moved
+    size_t headlessTick();
+    size_t moveAll(uint32_t types = kAllTypes);
+    template <NPC::Type T>
+    void moveNPC(World::Index npc, const Philox::Counter& words);
+    void compactWorld();
     void detectCombats();
-    bool processCombat(const CombatEvent& event);
+    void publishCombats();
+    void findPairs(DetectionMode mode, std::vector<CombatPair>& out);
+    void resolveCombats(const CombatEvent* events, size_t count, uint64_t firstSerial);
+    // serial numbers the event; it selects the dice stream
+    bool processCombat(const CombatEvent& event, uint64_t serial);
     void printMap();
+    void startProfiler();
+    
+    void findPairsBruteForce(std::vector<CombatPair>& out);
+    void findPairsGrid(std::vector<CombatPair>& out);
+    void findPairsSharded(std::vector<CombatPair>& out);
+    void gatherCandidates();
     
     int mapSize_;
     int npcCount_;
     int duration_;
+    uint64_t seed_;
+    bool verbose_;
+    LogLevel logLevel_;
+    LogFormat logFormat_;
+    std::string logPath_;
+    int viewportSize_;
+    int heatmapSize_;
+    bool profile_;
+    int profileInterval_;
+    std::string tracePath_;
+    uint64_t traceStart_;
+    uint64_t traceTicks_;
+    std::string checkpointPath_;
+    uint64_t checkpointEvery_;
+    std::string restorePath_;
+    
+    World world_;
+    CombatQueue combatQueue_;
+    OverflowPolicy overflowPolicy_;
+    std::vector<CombatEvent> events_;
+    std::vector<CombatEvent> evicted_;
+    
+    // Producer-side dedup: pair -> ring position of its queued event. A pair
+    // stays in flight until the combat thread resolves past that position,
+    // or until DropOldest evicts its event.
+    PairSet inFlight_;
+    PairSet inFlightNext_;
+    PairSet heldOverflow_;
+    std::atomic<size_t> resolvedPosition_;
+    // Set while the combat thread may hold popped, unresolved events
+    std::atomic<bool> combatBusy_;
     
-    std::vector<NPCPtr> npcs_;
-    std::queue<CombatEvent> combatQueue_;
+    std::atomic<uint64_t> eventsPublished_;
+    std::atomic<uint64_t> eventsDeduplicated_;
+    std::atomic<uint64_t> eventsDropped_;
+    std::atomic<uint64_t> eventsCoalesced_;
+    
+    // Broadphase state, reused between ticks
+    DetectionMode detectionMode_;
+    SpatialGrid grid_;
+    RegionShards shards_;
+    std::vector<int> candX_;
+    std::vector<int> candY_;
+    std::vector<int> candRange_;
+    std::vector<World::Index> candIndex_;
+    std::vector<uint8_t> aliveMask_;
+    std::vector<size_t> chunkAlive_;
+    std::vector<std::vector<SpatialGrid::Pair>> chunkPairs_;
+    std::vector<CombatPair> pairs_;
+    
+    // Published once per tick by the movement thread
+    SnapshotExchange snapshots_;
+    
+    // Rendering state, owned by the print thread
+    MapRenderer renderer_;
+    std::string frame_;
+    // Tick of the last printed frame
+    uint64_t printedTick_ = UINT64_MAX;
+    
+    Profiler profiler_;
+    CheckpointWriter checkpoints_;
     
     // Synchronization primitives
     std::shared_mutex npcsMutex_;
-    std::mutex combatQueueMutex_;
     std::mutex coutMutex_;
-    std::condition_variable combatCV_;
+    EventLog eventLog_;
     
     std::atomic<bool> running_;
+    std::atomic<uint64_t> tick_;
+    std::atomic<uint64_t> combatsResolved_;
+    std::atomic<uint64_t> kills_;
+    std::array<std::atomic<uint32_t>, GameOutcome::kTypes * GameOutcome::kTypes> killMatrix_{};
+    
+    ThreadPool pool_;
+    ThreadPool combatPool_;
+    CombatResolver resolver_;
+    uint64_t headlessSerial_;
+    // Combat thread events use serial serialBase_ + ring position; a
+    // restored run starts past the serials its checkpoint already used
+    uint64_t serialBase_;
     
+    // Movement ticks and printing fire from timer wheels, each run on its
+    // own thread; the combat thread sleeps on the queue instead
+    Scheduler tickScheduler_;
+    // Types whose move period came due since the last tick; movement
+    // thread only
+    uint32_t dueTypes_ = 0;
+    Scheduler printScheduler_;
     std::thread movementThread_;
     std::thread combatThread_;
     std::thread printThread_;
@@ -0,0 +1,41 @@
+#pragma once
+
+#include "world_snapshot.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Map area to rasterise, in world coordinates
+struct Viewport {
+    int x;
+    int y;
+    int width;
+    int height;
+
+    // width x height window centred on the map, clipped to it
+    static Viewport centred(int mapSize, int width, int height);
+};
+
+enum class HeatmapKind {
+    Density,   // glyph ramp by NPC count per cell
+    Type       // symbol of the most common type per cell
+};
+
+// Text renderer working from a WorldSnapshot. Only the requested area is
+// rasterised, into buffers reused across frames; output is appended to a
+// caller-owned string, so steady-state frames allocate nothing and hold
+// no simulation locks.
+class MapRenderer {
+public:
+    void renderViewport(const WorldSnapshot& snapshot, const Viewport& view, std::string& out);
+
+    // Whole map downsampled to columns x rows cells
+    void renderHeatmap(const WorldSnapshot& snapshot, int columns, int rows,
+                       HeatmapKind kind, std::string& out);
+
+    static char symbol(NPC::Type type);
+
+private:
+    std::vector<char> cells_;
+    std::vector<uint32_t> counts_;   // cells x type
+};
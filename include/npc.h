@@ -1,31 +1,42 @@
 #pragma once
 
-#include <string>
+#include "npc_types.h"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
 #include <memory>
-#include <random>
-#include <mutex>
-#include <atomic>
+#include <type_traits>
+#include <utility>
 
+class World;
+
+// Thin handle over one entry of a World store. All state lives in the
+// store; TypedNPC<T> answers the per-type constants from the traits table.
 class NPC {
 public:
-    enum class Type {
-        Knight,
-        Squirrel,
-        Pegasus
+    enum class Type : uint8_t {
+#define LAB7_NPC_ENUM(name, ...) name,
+        LAB7_NPC_TYPES(LAB7_NPC_ENUM)
+#undef LAB7_NPC_ENUM
     };
+#define LAB7_NPC_COUNT(...) + 1
+    static constexpr size_t kTypeCount = 0 LAB7_NPC_TYPES(LAB7_NPC_COUNT);
+#undef LAB7_NPC_COUNT
 
-    NPC(Type type, const std::string& name, int x, int y);
+    NPC(World& world, uint32_t index);
     virtual ~NPC() = default;
 
-    Type getType() const { return type_; }
-    std::string getName() const { return name_; }
+    uint32_t getIndex() const { return index_; }
+    Type getType() const;
+    std::string_view getName() const;
     
-    // Thread-safe position getters
+    // Lock-free position getters
     int getX() const;
     int getY() const;
     void getPosition(int& x, int& y) const;
     
-    bool isAlive() const { return alive_; }
+    bool isAlive() const;
 
     void setPosition(int x, int y);
     void kill();
@@ -33,26 +44,88 @@ public:
     virtual int getMovementRange() const = 0;
     virtual int getKillRange() const = 0;
     
-    // Combat methods
-    int rollDice() const;
+    // Combat methods: a d6 for the draw-th roll of this NPC under seed
+    int rollDice(uint64_t seed, uint64_t draw) const;
     virtual int getAttackBonus() const = 0;
     virtual int getDefenseBonus() const = 0;
 
     double distanceTo(const NPC& other) const;
-    int distanceSquaredTo(const NPC& other) const;
+    long long distanceSquaredTo(const NPC& other) const;
     
-    static std::string typeToString(Type type);
+    static std::string_view typeToString(Type type);
 
 protected:
-    Type type_;
-    std::string name_;
-    int x_;
-    int y_;
-    std::atomic<bool> alive_;
-    
-    mutable std::mutex posMutex_;
-    
-    static thread_local std::mt19937 rng_;
+    World* world_;
+    uint32_t index_;
 };
 
 using NPCPtr = std::shared_ptr<NPC>;
+
+// Per-type constants, indexed by NPC::Type
+struct NPCTraits {
+    const char* name;
+    char symbol;
+    int movementRange;
+    int killRange;
+    int attackBonus;
+    int defenseBonus;
+    int movePeriodMs;   // interactive move cadence
+};
+
+inline constexpr std::array<NPCTraits, NPC::kTypeCount> kNPCTraits = {{
+#define LAB7_NPC_TRAITS(name, symbol, movement, kill, attack, defense, period) \
+    {#name, symbol, movement, kill, attack, defense, period},
+    LAB7_NPC_TYPES(LAB7_NPC_TRAITS)
+#undef LAB7_NPC_TRAITS
+}};
+
+constexpr const NPCTraits& npcTraits(NPC::Type type) {
+    return kNPCTraits[static_cast<size_t>(type)];
+}
+
+// Sets of types, one bit per NPC::Type
+constexpr uint32_t typeBit(NPC::Type type) { return 1u << static_cast<unsigned>(type); }
+inline constexpr uint32_t kAllTypes = (1u << NPC::kTypeCount) - 1;
+
+// Compile-time view of one type's traits, for loops specialised per type
+template <NPC::Type T>
+struct TypeTraits {
+    static constexpr NPC::Type type = T;
+    static constexpr int movementRange = npcTraits(T).movementRange;
+    static constexpr int killRange = npcTraits(T).killRange;
+    static constexpr int attackBonus = npcTraits(T).attackBonus;
+    static constexpr int defenseBonus = npcTraits(T).defenseBonus;
+};
+
+template <NPC::Type T>
+using NPCTypeTag = std::integral_constant<NPC::Type, T>;
+
+// Calls f(NPCTypeTag<T>{}) for every type, in enum order
+template <typename F, size_t... I>
+void forEachNPCType(F&& f, std::index_sequence<I...>) {
+    (f(NPCTypeTag<static_cast<NPC::Type>(I)>{}), ...);
+}
+
+template <typename F>
+void forEachNPCType(F&& f) {
+    forEachNPCType(f, std::make_index_sequence<NPC::kTypeCount>{});
+}
+
+// Handle for one type; the constants come straight from the table
+template <NPC::Type T>
+class TypedNPC final : public NPC {
+public:
+    using Traits = TypeTraits<T>;
+
+    using NPC::NPC;
+
+    int getMovementRange() const override { return Traits::movementRange; }
+    int getKillRange() const override { return Traits::killRange; }
+    
+    int getAttackBonus() const override { return Traits::attackBonus; }
+    int getDefenseBonus() const override { return Traits::defenseBonus; }
+};
+
+#define LAB7_NPC_HANDLE(name, ...) using name = TypedNPC<NPC::Type::name>;
+LAB7_NPC_TYPES(LAB7_NPC_HANDLE)
+#undef LAB7_NPC_HANDLE
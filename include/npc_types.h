@@ -0,0 +1,14 @@
+#pragma once
+
+// The single list of NPC types. Everything per-type (the NPC::Type enum,
+// the traits table, handle classes, names and map symbols) is generated
+// from it, so adding a type means adding one line here.
+//
+// X(Name, symbol, movementRange, killRange, attackBonus, defenseBonus,
+//   movePeriodMs)
+// movePeriodMs is how often the type moves in interactive runs; headless,
+// batch and bench runs move every type on every tick.
+#define LAB7_NPC_TYPES(X)               \
+    X(Knight,   'K', 30, 10, 1, 1, 100) \
+    X(Squirrel, 'S',  5,  5, 0, 1,  50) \
+    X(Pegasus,  'P', 30, 10, 0, 2, 100)
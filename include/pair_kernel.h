@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Instruction set behind rangeMask, picked once from the running CPU
+enum class PairKernel {
+    Scalar,
+    Sse41,   // 4 candidates per step
+    Avx2,    // 8
+    Avx512   // 16
+};
+
+// Tests one NPC at (x, y) with kill range `range` against up to 64
+// candidates stored as contiguous arrays. Bit k of the result is set when
+// candidate k is within max(range, ranges[k]). Coordinates must differ by
+// less than 2^31 and ranges must be below 32767 (the vector variants clamp
+// |dx| and |dy| so squared distances fit in 32 bits).
+uint64_t rangeMask(int x, int y, int range,
+                   const int* xs, const int* ys, const int* ranges, size_t count);
+
+PairKernel activePairKernel();
+
+// Forces a variant, e.g. to compare them; false if the CPU lacks it
+bool selectPairKernel(PairKernel kernel);
+
+const char* pairKernelName(PairKernel kernel);
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Open-addressing hash map from an NPC pair to a 64-bit value (linear
+// probing). It never shrinks, so once sized for the working set a
+// clear/refill cycle per tick allocates nothing.
+class PairSet {
+public:
+    static uint64_t key(uint32_t first, uint32_t second) {
+        return (static_cast<uint64_t>(first) << 32) | second;
+    }
+
+    // Returns false (and keeps the old value) if the key is already present
+    bool insert(uint64_t key, uint64_t value);
+    // Returns false if the key was not present
+    bool erase(uint64_t key);
+    const uint64_t* find(uint64_t key) const;
+    bool contains(uint64_t key) const { return find(key) != nullptr; }
+
+    void clear();
+    size_t size() const { return size_; }
+    size_t capacity() const { return keys_.size(); }
+    bool empty() const { return size_ == 0; }
+
+    template <typename F>
+    void forEach(F&& f) const {
+        for (size_t i = 0; i < keys_.size(); ++i) {
+            if (keys_[i] != kEmpty) f(keys_[i], values_[i]);
+        }
+    }
+
+private:
+    // (UINT32_MAX, UINT32_MAX) is never a valid pair since attacker < defender
+    static constexpr uint64_t kEmpty = ~0ull;
+
+    void grow();
+    size_t homeOf(uint64_t key) const;
+    size_t slotOf(uint64_t key) const;
+
+    std::vector<uint64_t> keys_;
+    std::vector<uint64_t> values_;
+    size_t size_ = 0;
+};
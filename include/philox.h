@@ -0,0 +1,96 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+// Philox4x32-10 counter-based generator (Salmon et al., "Parallel random
+// numbers: as easy as 1, 2, 3"). The output is a pure function of a 64-bit
+// key and a 128-bit counter, so any thread can draw any value in any order
+// and a seed reproduces a run bit for bit regardless of thread count.
+struct Philox {
+    using Counter = std::array<uint32_t, 4>;
+
+    static constexpr uint32_t kMul0 = 0xD2511F53u;
+    static constexpr uint32_t kMul1 = 0xCD9E8D57u;
+    static constexpr uint32_t kWeyl0 = 0x9E3779B9u;
+    static constexpr uint32_t kWeyl1 = 0xBB67AE85u;
+
+    static Counter round(const Counter& c, uint32_t k0, uint32_t k1) {
+        uint64_t p0 = static_cast<uint64_t>(kMul0) * c[0];
+        uint64_t p1 = static_cast<uint64_t>(kMul1) * c[2];
+        return {static_cast<uint32_t>(p1 >> 32) ^ c[1] ^ k0, static_cast<uint32_t>(p1),
+                static_cast<uint32_t>(p0 >> 32) ^ c[3] ^ k1, static_cast<uint32_t>(p0)};
+    }
+
+    static Counter generate(Counter counter, uint64_t key) {
+        uint32_t k0 = static_cast<uint32_t>(key);
+        uint32_t k1 = static_cast<uint32_t>(key >> 32);
+        for (int r = 0; r < 10; ++r) {
+            counter = round(counter, k0, k1);
+            k0 += kWeyl0;
+            k1 += kWeyl1;
+        }
+        return counter;
+    }
+};
+
+// What a draw is for; part of the counter, so streams never overlap
+enum class RngPurpose : uint32_t {
+    Placement,
+    Movement,
+    Combat,
+    Dice,
+    BatchSeed   // per-game seeds of a BatchRunner
+};
+
+// Four independent 32-bit words for one (seed, tick, id, purpose)
+inline Philox::Counter randomWords(uint64_t seed, uint64_t tick, uint32_t id, RngPurpose purpose) {
+    return Philox::generate({id, static_cast<uint32_t>(tick), static_cast<uint32_t>(tick >> 32),
+                             static_cast<uint32_t>(purpose)}, seed);
+}
+
+// Maps a word onto [0, n) by multiply-shift; the bias is below n / 2^32
+inline uint32_t uniformBelow(uint32_t word, uint32_t n) {
+    return static_cast<uint32_t>((static_cast<uint64_t>(word) * n) >> 32);
+}
+
+// randomWords for a batch of ids sharing (seed, tick, purpose), written as
+// structure-of-arrays: word w of id k goes to out[w][k]. The rounds run
+// lane-parallel over kRandomBatch ids so the compiler can vectorise them.
+constexpr size_t kRandomBatch = 64;
+
+inline void randomWordsBatch(uint64_t seed, uint64_t tick, const uint32_t* ids, size_t count,
+                             RngPurpose purpose, uint32_t (*out)[kRandomBatch]) {
+    uint32_t c0[kRandomBatch], c1[kRandomBatch], c2[kRandomBatch], c3[kRandomBatch];
+    for (size_t k = 0; k < kRandomBatch; ++k) {
+        c0[k] = k < count ? ids[k] : 0;
+        c1[k] = static_cast<uint32_t>(tick);
+        c2[k] = static_cast<uint32_t>(tick >> 32);
+        c3[k] = static_cast<uint32_t>(purpose);
+    }
+
+    uint32_t k0 = static_cast<uint32_t>(seed);
+    uint32_t k1 = static_cast<uint32_t>(seed >> 32);
+    for (int r = 0; r < 10; ++r) {
+        for (size_t k = 0; k < kRandomBatch; ++k) {
+            uint64_t p0 = static_cast<uint64_t>(Philox::kMul0) * c0[k];
+            uint64_t p1 = static_cast<uint64_t>(Philox::kMul1) * c2[k];
+            uint32_t n0 = static_cast<uint32_t>(p1 >> 32) ^ c1[k] ^ k0;
+            uint32_t n2 = static_cast<uint32_t>(p0 >> 32) ^ c3[k] ^ k1;
+            c1[k] = static_cast<uint32_t>(p1);
+            c3[k] = static_cast<uint32_t>(p0);
+            c0[k] = n0;
+            c2[k] = n2;
+        }
+        k0 += Philox::kWeyl0;
+        k1 += Philox::kWeyl1;
+    }
+
+    for (size_t k = 0; k < count; ++k) {
+        out[0][k] = c0[k];
+        out[1][k] = c1[k];
+        out[2][k] = c2[k];
+        out[3][k] = c3[k];
+    }
+}
@@ -0,0 +1,175 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <string>
+
+// Built with -DLAB7_PROFILING (CMake option LAB7_PROFILING). Without it
+// enabled() is a compile-time false and every recording call folds away.
+#ifdef LAB7_PROFILING
+constexpr bool kProfilingBuilt = true;
+#else
+constexpr bool kProfilingBuilt = false;
+#endif
+
+// Timed sections of a tick
+enum class Phase {
+    Tick,         // whole simulation step, excluding the pacing sleep
+    Move,
+    Detect,
+    Publish,      // dedup and hand-off to the combat queue
+    QueueStall,   // producer blocked on a full combat queue
+    Resolve,
+    CombatIdle,   // combat thread waiting for events
+    Snapshot,
+    Render,
+    Count
+};
+
+// Instrumented mutexes
+enum class LockSite {
+    Npcs,   // npcsMutex_, shared and exclusive
+    Cout,   // coutMutex_, shared by the map printer, the combat log and stats
+    Count
+};
+
+// Log-linear histogram of nanoseconds (or any non-negative value): eight
+// buckets per power of two up to 2^47. Lock-free, safe from any thread.
+class Histogram {
+public:
+    static constexpr size_t kBuckets = 46 * 8;
+
+    void record(uint64_t value);
+    void reset();
+
+    uint64_t count() const { return count_.load(std::memory_order_relaxed); }
+    uint64_t max() const { return max_.load(std::memory_order_relaxed); }
+    double mean() const;
+    // Upper bound of the bucket holding the q-th quantile
+    uint64_t percentile(double q) const;
+
+private:
+    std::array<std::atomic<uint64_t>, kBuckets> buckets_{};
+    std::atomic<uint64_t> count_{0};
+    std::atomic<uint64_t> sum_{0};
+    std::atomic<uint64_t> max_{0};
+};
+
+// Per-phase latency and per-lock wait/hold histograms, a queue depth
+// histogram, and an optional Chrome trace (chrome://tracing, Perfetto) of
+// a bounded window of ticks kept in a preallocated event buffer.
+class Profiler {
+public:
+    static constexpr size_t kTraceCapacity = 1 << 18;   // events
+
+    static uint64_t now() {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count());
+    }
+
+    bool enabled() const { return kProfilingBuilt && enabled_; }
+
+    // Enables recording; traceTicks > 0 also traces ticks
+    // [traceStart, traceStart + traceTicks)
+    void start(uint64_t traceStart = 0, uint64_t traceTicks = 0);
+    void reset();
+
+    // Called by the tick loop before each tick's work
+    void beginTick(uint64_t tick);
+
+    void recordPhase(Phase phase, uint64_t startNs, uint64_t endNs);
+    void recordLockWait(LockSite site, uint64_t startNs, uint64_t endNs);
+    void recordLockHold(LockSite site, uint64_t ns);
+    void recordQueueDepth(size_t depth);
+
+    // Human-readable summary of everything recorded since start()
+    void dump(std::ostream& out) const;
+    // Chrome trace-event JSON of the traced window
+    void writeTrace(const std::string& path) const;
+
+    static const char* phaseName(Phase phase);
+    static const char* lockName(LockSite site);
+
+private:
+    struct TraceEvent {
+        const char* name;
+        uint64_t startNs;
+        uint64_t value;     // duration for spans, the sample for counters
+        uint32_t thread;
+        bool counter;
+    };
+
+    void trace(const char* name, uint64_t startNs, uint64_t value, bool counter);
+
+    bool enabled_ = false;
+    uint64_t startNs_ = 0;
+    std::atomic<uint64_t> ticks_{0};
+
+    std::array<Histogram, static_cast<size_t>(Phase::Count)> phases_;
+    std::array<Histogram, static_cast<size_t>(LockSite::Count)> lockWait_;
+    std::array<Histogram, static_cast<size_t>(LockSite::Count)> lockHold_;
+    Histogram queueDepth_;
+
+    uint64_t traceStart_ = 0;
+    uint64_t traceEnd_ = 0;
+    std::atomic<bool> tracing_{false};
+    std::unique_ptr<TraceEvent[]> traceEvents_;
+    std::atomic<size_t> traceCount_{0};
+};
+
+// Times a scope as one phase
+class PhaseTimer {
+public:
+    PhaseTimer(Profiler& profiler, Phase phase)
+        : profiler_(profiler.enabled() ? &profiler : nullptr), phase_(phase),
+          start_(profiler_ ? Profiler::now() : 0) {}
+    ~PhaseTimer() {
+        if (profiler_) profiler_->recordPhase(phase_, start_, Profiler::now());
+    }
+
+    PhaseTimer(const PhaseTimer&) = delete;
+    PhaseTimer& operator=(const PhaseTimer&) = delete;
+
+private:
+    Profiler* profiler_;
+    Phase phase_;
+    uint64_t start_;
+};
+
+// Wraps a standard lock (std::unique_lock, std::shared_lock, ...) and
+// records how long acquiring it waited and how long it was held
+template <typename Lock>
+class ProfiledLock {
+public:
+    template <typename Mutex>
+    ProfiledLock(Profiler& profiler, LockSite site, Mutex& mutex)
+        : profiler_(profiler.enabled() ? &profiler : nullptr), site_(site),
+          requested_(profiler_ ? Profiler::now() : 0), lock_(mutex),
+          acquired_(profiler_ ? Profiler::now() : 0) {
+        if (profiler_) profiler_->recordLockWait(site_, requested_, acquired_);
+    }
+
+    ~ProfiledLock() {
+        if (lock_.owns_lock()) unlock();
+    }
+
+    ProfiledLock(const ProfiledLock&) = delete;
+    ProfiledLock& operator=(const ProfiledLock&) = delete;
+
+    void unlock() {
+        lock_.unlock();
+        if (profiler_) profiler_->recordLockHold(site_, Profiler::now() - acquired_);
+    }
+
+private:
+    Profiler* profiler_;
+    LockSite site_;
+    uint64_t requested_;
+    Lock lock_;
+    uint64_t acquired_;
+};
@@ -0,0 +1,81 @@
+#pragma once
+
+#include "spatial_grid.h"
+#include "thread_pool.h"
+#include "world.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Combat detection over horizontal strips of the map ("shards"). Each
+// shard keeps the list of NPCs inside its strip and runs its own grid, so
+// every phase is one parallel loop over shards with no shared writes.
+//
+// Per tick:
+//  1. migrate: each shard drops dead members and hands the ones that moved
+//     out of its strip to the neighbour above or below (or, for longer
+//     jumps, to a list every shard checks)
+//  2. adopt: each shard takes in its migrants and exports a halo, the copy
+//     of its members within `halo` of its lower edge
+//  3. detect: each shard appends the halo of the shard above to its own
+//     members and finds pairs with the member side in this shard; a pair
+//     across a boundary is therefore reported once, by the lower shard
+//
+// Strips are at least `halo` (the largest kill range) tall, so pairs never
+// span more than two shards. The shard count depends only on the map, not
+// the thread count, so pair order and results are the same for any pool.
+class RegionShards {
+public:
+    using Pair = SpatialGrid::Pair;
+
+    static constexpr size_t kMaxShards = 256;
+
+    // Chooses the strip layout; membership is rebuilt on the next findPairs
+    void configure(int mapSize, int halo);
+    // Forget membership, e.g. after the world was re-initialised
+    void invalidate() { assigned_ = false; }
+
+    // Appends every alive pair in range as (lower index, higher index),
+    // shard by shard and sorted within a shard. Positions must not change
+    // during the call.
+    void findPairs(const World& world, ThreadPool& pool, std::vector<Pair>& out);
+
+    size_t shardCount() const { return shards_.size(); }
+    uint64_t migrations() const { return migrations_; }
+
+private:
+    struct Shard {
+        std::vector<World::Index> members;
+        std::vector<World::Index> up;     // migrants to the shard above
+        std::vector<World::Index> down;   // migrants to the shard below
+        std::vector<World::Index> far;    // migrants that skipped a shard
+
+        // Members first, then the halo of the shard above
+        std::vector<int> xs;
+        std::vector<int> ys;
+        std::vector<int> ranges;
+        std::vector<World::Index> indices;
+
+        // Exported boundary strip
+        std::vector<int> haloX;
+        std::vector<int> haloY;
+        std::vector<int> haloRange;
+        std::vector<World::Index> haloIndex;
+
+        SpatialGrid grid;
+        std::vector<Pair> pairs;
+    };
+
+    size_t shardOf(int y) const;
+    void assign(const World& world);
+    void migrate(const World& world, size_t s);
+    void adopt(const World& world, size_t s);
+    void detect(size_t s);
+
+    int mapSize_ = 0;
+    int halo_ = 1;
+    int stripHeight_ = 1;
+    bool assigned_ = false;
+    uint64_t migrations_ = 0;
+    std::vector<Shard> shards_;
+};
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+// Periodic task scheduler on a hashed timer wheel.
+// Time is divided into slots of one resolution each; a task sits in the
+// slot of its next due slot number modulo the wheel size. run() works out
+// the next occupied slot, sleeps on a condition variable until it is due
+// (or stop() is called) and runs its tasks on the calling thread, so an
+// idle scheduler never wakes. A task that overruns pushes its own next run
+// forward instead of firing a burst of missed ones.
+class Scheduler {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    explicit Scheduler(Clock::duration resolution = std::chrono::milliseconds(10));
+
+    // Runs task every period (rounded up to whole slots), the first time
+    // one period after run() starts. Tasks due in the same slot run in the
+    // order they were added. Not thread-safe; call before run().
+    void every(Clock::duration period, std::function<void()> task);
+    // Drops all tasks and clears a previous stop()
+    void reset();
+
+    // Runs due tasks on the calling thread until stop()
+    void run();
+    // Safe from any thread; wakes run() at once
+    void stop();
+
+private:
+    static constexpr size_t kSlots = 256;
+
+    struct Task {
+        uint64_t period;   // in slots
+        uint64_t due;      // absolute slot number
+        std::function<void()> run;
+    };
+
+    void insert(size_t task);
+    // Earliest due slot, scanning forward from slot `from`
+    uint64_t nextDue(uint64_t from) const;
+
+    Clock::duration resolution_;
+    std::vector<Task> tasks_;
+    std::array<std::vector<size_t>, kSlots> wheel_;
+    std::vector<size_t> due_;
+
+    std::mutex mutex_;
+    std::condition_variable wakeCV_;
+    bool stopping_ = false;
+};
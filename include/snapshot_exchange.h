@@ -0,0 +1,76 @@
+#pragma once
+
+#include "world_snapshot.h"
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+
+// Hands the latest WorldSnapshot from one writer (the tick loop) to any
+// number of readers without locks. Slots are recycled rather than freed:
+// each has a reader count, the writer only fills a slot that is neither
+// current nor held, and a reader re-checks that its slot is still current
+// after pinning it. Neither side ever waits. kInitialSlots cover the usual
+// readers; when every spare slot is pinned the writer adds a slot (the
+// only allocation after the first publishes), and once kMaxSlots are all
+// pinned it skips the publish, leaving readers on the previous tick.
+class SnapshotExchange {
+public:
+    static constexpr size_t kInitialSlots = 4;
+    static constexpr size_t kMaxSlots = 64;
+
+    // Pins one published snapshot for as long as it lives
+    class Reader {
+    public:
+        Reader() = default;
+        Reader(Reader&& other) noexcept;
+        Reader& operator=(Reader&& other) noexcept;
+        ~Reader();
+
+        explicit operator bool() const { return exchange_ != nullptr; }
+        const WorldSnapshot& operator*() const { return exchange_->slots_[slot_]->snapshot; }
+        const WorldSnapshot* operator->() const { return &exchange_->slots_[slot_]->snapshot; }
+
+    private:
+        friend class SnapshotExchange;
+        Reader(const SnapshotExchange* exchange, size_t slot) : exchange_(exchange), slot_(slot) {}
+        void release();
+
+        const SnapshotExchange* exchange_ = nullptr;
+        size_t slot_ = 0;
+    };
+
+    SnapshotExchange();
+    SnapshotExchange(const SnapshotExchange&) = delete;
+    SnapshotExchange& operator=(const SnapshotExchange&) = delete;
+
+    // Latest published snapshot; empty before the first publish
+    Reader acquire() const;
+
+    // Single writer: capture the world into a free slot and make it current.
+    // Returns false (and counts a skip) if all kMaxSlots are pinned.
+    bool publish(const World& world, uint64_t tick, int mapSize);
+
+    uint64_t published() const { return published_.load(std::memory_order_relaxed); }
+    uint64_t skipped() const { return skipped_.load(std::memory_order_relaxed); }
+    size_t slotCount() const { return slotCount_; }
+
+private:
+    struct alignas(64) Slot {
+        std::atomic<uint32_t> readers{0};
+        WorldSnapshot snapshot;
+    };
+
+    static constexpr size_t kNone = kMaxSlots;
+
+    // A free slot, adding one if needed; kNone if all kMaxSlots are pinned
+    size_t claimSlot();
+
+    // Slots are only added by the writer, before their index can become
+    // current, and never removed, so readers index them without a lock
+    mutable std::array<std::unique_ptr<Slot>, kMaxSlots> slots_;
+    size_t slotCount_ = 0;
+    alignas(64) std::atomic<size_t> current_{kNone};
+    std::atomic<uint64_t> published_{0};
+    std::atomic<uint64_t> skipped_{0};
+};
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+// Uniform grid broadphase over a sort-by-cell layout.
+// Cells are hashed into a power-of-two bucket table, so memory stays O(n)
+// no matter how large the map is. With a cell size equal to the largest
+// kill range, every pair in range lies in the same or a neighbouring cell.
+// Each bucket keeps contiguous copies of its points' x, y and range, so a
+// point is tested against a whole bucket at once with rangeMask.
+class SpatialGrid {
+public:
+    using Pair = std::pair<uint32_t, uint32_t>;
+
+    // Re-bucket all points. Positions must be non-negative.
+    void rebuild(const int* xs, const int* ys, const int* ranges, size_t count, int cellSize);
+
+    // Appends every pair (a, b) with a in [begin, end), a < b and
+    // distance^2 <= max(ranges[a], ranges[b])^2, ordered by a then b.
+    void findPairs(const int* xs, const int* ys, const int* ranges,
+                   size_t begin, size_t end, std::vector<Pair>& out) const;
+
+    size_t size() const { return cellX_.size(); }
+    int cellSize() const { return cellSize_; }
+
+private:
+    size_t bucketOf(int cx, int cy) const;
+
+    int cellSize_ = 1;
+    size_t mask_ = 0;
+
+    std::vector<int> cellX_;
+    std::vector<int> cellY_;
+    std::vector<uint32_t> bucketStart_;  // buckets + 1 offsets into sorted_
+    std::vector<uint32_t> sorted_;       // point indices ordered by bucket
+    std::vector<int> sortedX_;           // positions and ranges in sorted_ order
+    std::vector<int> sortedY_;
+    std::vector<int> sortedRange_;
+};
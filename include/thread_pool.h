@@ -0,0 +1,76 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+// Fixed pool of workers for data-parallel loops.
+// parallelFor cuts [begin, end) into grain-sized chunks and deals them out
+// evenly to per-worker ranges; a worker that runs dry steals half of the
+// chunks left in another worker's range. The caller takes part as worker 0
+// and returns only once every chunk has run, so back-to-back calls act as a
+// barrier between simulation phases.
+class ThreadPool {
+public:
+    // threads counts the caller; 0 picks std::thread::hardware_concurrency()
+    explicit ThreadPool(unsigned threads = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    unsigned size() const { return static_cast<unsigned>(queues_.size()); }
+
+    // f(size_t chunkBegin, size_t chunkEnd, unsigned worker)
+    template <typename F>
+    void parallelFor(size_t begin, size_t end, size_t grain, F&& f) {
+        using Fn = std::remove_reference_t<F>;
+        run(begin, end, grain,
+            [](void* ctx, size_t b, size_t e, unsigned worker) {
+                (*static_cast<Fn*>(ctx))(b, e, worker);
+            },
+            const_cast<void*>(static_cast<const void*>(&f)));
+    }
+
+private:
+    using ChunkFn = void (*)(void* ctx, size_t begin, size_t end, unsigned worker);
+
+    // Remaining chunk indices [front, back) packed into one word so the owner
+    // (popping the front) and thieves (splitting off the back) can use CAS
+    struct alignas(64) Queue {
+        std::atomic<uint64_t> range{0};
+    };
+
+    static uint64_t packRange(uint32_t front, uint32_t back) {
+        return (static_cast<uint64_t>(back) << 32) | front;
+    }
+
+    void run(size_t begin, size_t end, size_t grain, ChunkFn fn, void* ctx);
+    void workerLoop(unsigned worker);
+    void work(unsigned worker);
+    bool popChunk(unsigned worker, uint32_t& chunk);
+    bool steal(unsigned thief);
+    void runChunk(uint32_t chunk, unsigned worker);
+
+    std::vector<Queue> queues_;
+    std::vector<std::thread> workers_;
+
+    // Current job; written before the queues are filled
+    ChunkFn fn_ = nullptr;
+    void* ctx_ = nullptr;
+    size_t begin_ = 0;
+    size_t end_ = 0;
+    size_t grain_ = 1;
+    std::atomic<size_t> pending_{0};
+
+    std::mutex callMutex_;
+    std::mutex wakeMutex_;
+    std::condition_variable wakeCV_;
+    uint64_t generation_ = 0;
+    bool stop_ = false;
+};
@@ -0,0 +1,164 @@
+#pragma once
+
+#include "npc.h"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <vector>
+
+// Structure-of-arrays NPC store.
+// Positions, types, alive flags and per-type ordinals live in contiguous
+// arrays indexed by a stable NPC index. x/y are packed into one atomic
+// 64-bit word per NPC, so position reads and writes never take a lock.
+// NPC objects are thin handles over this store (see npc()).
+//
+// Indices are never reused, so a stale index (say, in a queued combat
+// event) simply reads as dead. Iteration goes through the active list
+// instead of 0..size(): dead NPCs are dropped from it by compact(), so
+// per-tick loops scale with the live population.
+class World {
+public:
+    using Index = uint32_t;
+
+    // Not thread-safe: only call while no other thread reads the store
+    void reserve(size_t capacity);
+    Index add(NPC::Type type, int x, int y);
+    void clear();
+
+    // Bulk construction: resize() appends uninitialised slots, place() fills
+    // them (safe from several threads for distinct indices), and reindex()
+    // then rebuilds ordinals and the active and per-type lists. Loading a
+    // checkpoint or placing a fresh world this way parallelises the fill.
+    void resize(size_t count);
+    void place(Index i, NPC::Type type, uint64_t packed, bool alive) {
+        positions_[i].store(packed, std::memory_order_relaxed);
+        alive_[i].store(alive ? 1 : 0, std::memory_order_relaxed);
+        names_[i].store(nullptr, std::memory_order_relaxed);
+        types_[i] = type;
+    }
+    void reindex();
+
+    size_t size() const { return size_; }
+
+    // Alive NPCs plus those killed since the last compact(), ascending
+    const std::vector<Index>& active() const { return active_; }
+    size_t activeCount() const { return active_.size(); }
+
+    // True once enough of the active list is dead to be worth a compact()
+    bool compactionDue() const {
+        int64_t dead = pendingDead_.load(std::memory_order_relaxed);
+        return dead > 0 && static_cast<size_t>(dead) * kCompactFraction >= active_.size();
+    }
+    // Drops dead NPCs from the active and per-type lists. Not thread-safe
+    // against readers of those lists; concurrent kills are fine.
+    void compact();
+
+    static uint64_t pack(int x, int y) {
+        return (static_cast<uint64_t>(static_cast<uint32_t>(x)) << 32) |
+               static_cast<uint32_t>(y);
+    }
+    static void unpack(uint64_t packed, int& x, int& y) {
+        x = static_cast<int32_t>(static_cast<uint32_t>(packed >> 32));
+        y = static_cast<int32_t>(static_cast<uint32_t>(packed));
+    }
+
+    uint64_t packedPosition(Index i) const {
+        return positions_[i].load(std::memory_order_relaxed);
+    }
+    void getPosition(Index i, int& x, int& y) const { unpack(packedPosition(i), x, y); }
+    void setPosition(Index i, int x, int y) {
+        positions_[i].store(pack(x, y), std::memory_order_relaxed);
+    }
+
+    NPC::Type type(Index i) const { return types_[i]; }
+    uint32_t ordinal(Index i) const { return ordinals_[i]; }
+    // "Knight_3", formatted on first use and interned in an arena; the
+    // view stays valid until clear(). Lock-free once interned.
+    std::string_view name(Index i) const {
+        const char* entry = names_[i].load(std::memory_order_acquire);
+        if (entry == nullptr) entry = internName(i);
+        return {entry + 1, static_cast<unsigned char>(entry[0])};
+    }
+
+    bool isAlive(Index i) const { return alive_[i].load(std::memory_order_acquire) != 0; }
+    void kill(Index i) {
+        if (alive_[i].exchange(0, std::memory_order_acq_rel)) countKill(i);
+    }
+    // Claims the kill: true only for the one caller that flips alive -> dead
+    bool tryKill(Index i) {
+        uint8_t alive = 1;
+        if (!alive_[i].compare_exchange_strong(alive, 0, std::memory_order_acq_rel)) return false;
+        countKill(i);
+        return true;
+    }
+    // Alive NPCs of one type, kept up to date by every kill
+    uint32_t aliveOfType(NPC::Type type) const {
+        return aliveByType_[static_cast<size_t>(type)].load(std::memory_order_relaxed);
+    }
+
+    int killRange(Index i) const { return npcTraits(types_[i]).killRange; }
+    int movementRange(Index i) const { return npcTraits(types_[i]).movementRange; }
+
+    // Active NPC indices grouped by type, ascending within each type
+    const std::vector<Index>& ofType(NPC::Type type) const {
+        return typeIndices_[static_cast<size_t>(type)];
+    }
+
+    // Visits positions [begin, end) of the type-grouped order (all of one
+    // type, then the next; activeCount() positions in total) as runs of one type:
+    // f(NPCTypeTag<T>{}, indices, count). The tag lets f be a generic
+    // lambda whose body is compiled once per type with constant traits.
+    template <typename F>
+    void forEachTypeRun(size_t begin, size_t end, F&& f) const {
+        size_t offset = 0;
+        forEachNPCType([&](auto tag) {
+            const auto& indices = typeIndices_[static_cast<size_t>(decltype(tag)::value)];
+            size_t first = std::max(begin, offset);
+            size_t last = std::min(end, offset + indices.size());
+            if (first < last) f(tag, indices.data() + (first - offset), last - first);
+            offset += indices.size();
+        });
+    }
+
+    // Allocates a handle; meant for cold paths, not per-tick loops
+    NPCPtr npc(Index i);
+
+private:
+    static constexpr size_t kNameBlockSize = 64 * 1024;
+    // compactionDue() once 1/8 of the active list is dead
+    static constexpr size_t kCompactFraction = 8;
+
+    NPCPtr makeHandle(NPC::Type type, Index i);
+    void countKill(Index i) {
+        pendingDead_.fetch_add(1, std::memory_order_relaxed);
+        aliveByType_[static_cast<size_t>(types_[i])].fetch_sub(1, std::memory_order_relaxed);
+    }
+    const char* internName(Index i) const;
+
+    size_t size_ = 0;
+    size_t capacity_ = 0;
+
+    std::unique_ptr<std::atomic<uint64_t>[]> positions_;
+    std::unique_ptr<std::atomic<uint8_t>[]> alive_;
+    std::unique_ptr<NPC::Type[]> types_;
+    std::unique_ptr<uint32_t[]> ordinals_;
+
+    // Interned names: length byte then characters, in blocks that never move
+    mutable std::unique_ptr<std::atomic<const char*>[]> names_;
+    mutable std::vector<std::unique_ptr<char[]>> nameBlocks_;
+    mutable size_t nameBlock_ = 0;
+    mutable size_t nameUsed_ = 0;
+    mutable std::mutex nameMutex_;
+
+    std::vector<Index> active_;
+    std::array<std::vector<Index>, NPC::kTypeCount> typeIndices_;
+    std::array<uint32_t, NPC::kTypeCount> typeCounts_{};   // NPCs ever added, per type
+    // Kills not yet compacted away; may dip below zero while a kill that
+    // compact() already saw is still being counted
+    std::atomic<int64_t> pendingDead_{0};
+    std::array<std::atomic<uint32_t>, NPC::kTypeCount> aliveByType_{};
+};
@@ -0,0 +1,22 @@
+#pragma once
+
+#include "world.h"
+#include <cstdint>
+#include <vector>
+
+// Immutable copy of the alive NPCs at one tick, for readers that must not
+// touch the live store (rendering, statistics, exporters). Capturing into
+// an existing snapshot reuses its buffers.
+struct WorldSnapshot {
+    uint64_t tick = 0;
+    int mapSize = 0;
+    size_t total = 0;   // NPCs in the store, dead included
+
+    std::vector<uint64_t> positions;   // packed as in World::pack
+    std::vector<NPC::Type> types;
+    std::vector<World::Index> indices;
+
+    size_t alive() const { return positions.size(); }
+
+    void capture(const World& world, uint64_t tick, int mapSize);
+};
@@ -0,0 +1,155 @@
+#include "../include/batch_runner.h"
+#include "../include/philox.h"
+#include <algorithm>
+#include <chrono>
+#include <exception>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+
+namespace {
+// Games a worker claims at a time; keeps the shared counter cold
+constexpr uint64_t kGamesPerClaim = 16;
+}
+
+void BatchSummary::add(const GameOutcome& outcome) {
+    ++games;
+    ticks += static_cast<uint64_t>(outcome.ticks);
+    for (size_t t = 0; t < kTypes; ++t) {
+        survivors[t] += outcome.survivors[t];
+        if (outcome.survivors[t] > 0) ++gamesSurvived[t];
+
+        int tick = outcome.extinctionTick[t];
+        if (tick < 0) continue;
+        auto& counts = extinctions[t];
+        if (counts.size() <= static_cast<size_t>(tick)) counts.resize(static_cast<size_t>(tick) + 1);
+        ++counts[static_cast<size_t>(tick)];
+    }
+    for (size_t c = 0; c < kills.size(); ++c) {
+        kills[c] += outcome.kills[c];
+    }
+}
+
+void BatchSummary::merge(const BatchSummary& other) {
+    games += other.games;
+    ticks += other.ticks;
+    for (size_t t = 0; t < kTypes; ++t) {
+        survivors[t] += other.survivors[t];
+        gamesSurvived[t] += other.gamesSurvived[t];
+
+        auto& counts = extinctions[t];
+        const auto& theirs = other.extinctions[t];
+        if (counts.size() < theirs.size()) counts.resize(theirs.size());
+        for (size_t tick = 0; tick < theirs.size(); ++tick) {
+            counts[tick] += theirs[tick];
+        }
+    }
+    for (size_t c = 0; c < kills.size(); ++c) {
+        kills[c] += other.kills[c];
+    }
+}
+
+uint64_t BatchSummary::extinctionCount(size_t type) const {
+    uint64_t count = 0;
+    for (uint64_t games : extinctions[type]) count += games;
+    return count;
+}
+
+double BatchSummary::meanExtinctionTick(size_t type) const {
+    uint64_t count = 0;
+    uint64_t sum = 0;
+    const auto& counts = extinctions[type];
+    for (size_t tick = 0; tick < counts.size(); ++tick) {
+        count += counts[tick];
+        sum += counts[tick] * tick;
+    }
+    return count ? static_cast<double>(sum) / static_cast<double>(count) : 0.0;
+}
+
+int BatchSummary::extinctionPercentile(size_t type, double q) const {
+    uint64_t count = extinctionCount(type);
+    if (count == 0) return -1;
+
+    uint64_t rank = static_cast<uint64_t>(q * static_cast<double>(count - 1)) + 1;
+    uint64_t seen = 0;
+    const auto& counts = extinctions[type];
+    for (size_t tick = 0; tick < counts.size(); ++tick) {
+        seen += counts[tick];
+        if (seen >= rank) return static_cast<int>(tick);
+    }
+    return static_cast<int>(counts.size()) - 1;
+}
+
+BatchRunner::BatchRunner(const BatchConfig& config) : config_(config) {
+    if (config_.mapSize <= 0 || config_.npcCount < 0) {
+        throw std::invalid_argument("map size must be positive and NPC count non-negative");
+    }
+    if (config_.maxTicks <= 0) {
+        throw std::invalid_argument("batch games need a positive tick limit");
+    }
+}
+
+uint64_t BatchRunner::gameSeed(uint64_t batchSeed, uint64_t game) {
+    Philox::Counter words = randomWords(batchSeed, game, 0, RngPurpose::BatchSeed);
+    uint64_t seed = (static_cast<uint64_t>(words[0]) << 32) | words[1];
+    return seed != 0 ? seed : 1;
+}
+
+BatchSummary BatchRunner::run() {
+    unsigned workers = config_.workers;
+    if (workers == 0) workers = std::max(1u, std::thread::hardware_concurrency());
+    workers = static_cast<unsigned>(std::min<uint64_t>(workers, std::max<uint64_t>(1, config_.games)));
+
+    std::vector<BatchSummary> summaries(workers);
+    std::atomic<uint64_t> next{0};
+    std::exception_ptr failure;
+    std::mutex failureMutex;
+
+    auto start = std::chrono::steady_clock::now();
+
+    // The calling thread is worker 0
+    auto body = [&](unsigned w) {
+        try {
+            work(next, summaries[w]);
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(failureMutex);
+            if (!failure) failure = std::current_exception();
+            next.store(config_.games, std::memory_order_relaxed);
+        }
+    };
+    std::vector<std::thread> threads;
+    for (unsigned w = 1; w < workers; ++w) {
+        threads.emplace_back(body, w);
+    }
+    body(0);
+    for (auto& thread : threads) thread.join();
+    if (failure) std::rethrow_exception(failure);
+
+    BatchSummary total;
+    for (const auto& summary : summaries) total.merge(summary);
+    total.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return total;
+}
+
+void BatchRunner::work(std::atomic<uint64_t>& next, BatchSummary& summary) {
+    // Parallelism is across games, so each game runs on one thread
+    GameConfig config;
+    config.mapSize = config_.mapSize;
+    config.npcCount = config_.npcCount;
+    config.threads = 1;
+    config.combatThreads = 1;
+    config.seed = 1;
+    config.combatQueueCapacity = 64;
+    config.logLevel = LogLevel::Off;
+    Game game(config);
+
+    while (true) {
+        uint64_t first = next.fetch_add(kGamesPerClaim, std::memory_order_relaxed);
+        if (first >= config_.games) return;
+        uint64_t last = std::min(config_.games, first + kGamesPerClaim);
+
+        for (uint64_t g = first; g < last; ++g) {
+            summary.add(game.playOut(gameSeed(config_.seed, g), config_.maxTicks));
+        }
+    }
+}
@@ -0,0 +1,241 @@
+#include "../include/checkpoint.h"
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+constexpr char kCheckpointMagic[8] = {'L', '7', 'C', 'K', 'P', 'T', '\0', '\1'};
+constexpr uint32_t kCheckpointVersion = 1;
+
+// NPCs per chunk when filling the world from a mapped file
+constexpr size_t kLoadGrain = 16384;
+
+std::string systemError(const std::string& what, const std::string& path) {
+    return what + " '" + path + "': " + std::strerror(errno);
+}
+
+// Read-only mapping of a whole file, unmapped on scope exit
+class MappedFile {
+public:
+    explicit MappedFile(const std::string& path) {
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) throw std::runtime_error(systemError("cannot open checkpoint", path));
+
+        struct stat info {};
+        if (::fstat(fd, &info) == 0) size_ = static_cast<size_t>(info.st_size);
+        if (size_ > 0) {
+            void* data = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (data != MAP_FAILED) {
+                data_ = static_cast<const char*>(data);
+                ::madvise(data, size_, MADV_SEQUENTIAL);
+            }
+        }
+        ::close(fd);
+        if (data_ == nullptr) throw std::runtime_error(systemError("cannot map checkpoint", path));
+    }
+    ~MappedFile() { ::munmap(const_cast<char*>(data_), size_); }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    const char* data() const { return data_; }
+    size_t size() const { return size_; }
+
+private:
+    const char* data_ = nullptr;
+    size_t size_ = 0;
+};
+
+bool writeAll(int fd, const void* data, size_t size) {
+    const char* bytes = static_cast<const char*>(data);
+    while (size > 0) {
+        ssize_t written = ::write(fd, bytes, size);
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        bytes += written;
+        size -= static_cast<size_t>(written);
+    }
+    return true;
+}
+}
+
+CheckpointState loadCheckpoint(const std::string& path, World& world, ThreadPool& pool) {
+    MappedFile file(path);
+
+    CheckpointHeader header;
+    if (file.size() < sizeof(header)) {
+        throw std::runtime_error("checkpoint '" + path + "' is truncated");
+    }
+    std::memcpy(&header, file.data(), sizeof(header));
+    if (std::memcmp(header.magic, kCheckpointMagic, sizeof(kCheckpointMagic)) != 0) {
+        throw std::runtime_error("'" + path + "' is not a checkpoint");
+    }
+    if (header.version != kCheckpointVersion || header.headerSize != sizeof(header) ||
+        header.typeCount != NPC::kTypeCount) {
+        throw std::runtime_error("checkpoint '" + path + "' was written by an incompatible build");
+    }
+    size_t count = static_cast<size_t>(header.count);
+    if (header.mapSize <= 0 || count > UINT32_MAX ||
+        file.size() != sizeof(header) + count * (sizeof(uint64_t) + 2)) {
+        throw std::runtime_error("checkpoint '" + path + "' is truncated or corrupt");
+    }
+
+    const auto* positions = reinterpret_cast<const uint64_t*>(file.data() + sizeof(header));
+    const auto* types = reinterpret_cast<const uint8_t*>(positions + count);
+    const uint8_t* alive = types + count;
+
+    world.clear();
+    world.resize(count);
+    std::atomic<bool> corrupt{false};
+    pool.parallelFor(0, count, kLoadGrain, [&](size_t begin, size_t end, unsigned) {
+        for (size_t i = begin; i < end; ++i) {
+            int x, y;
+            World::unpack(positions[i], x, y);
+            if (types[i] >= NPC::kTypeCount || x < 0 || y < 0 ||
+                x >= header.mapSize || y >= header.mapSize) {
+                corrupt.store(true, std::memory_order_relaxed);
+                continue;
+            }
+            world.place(static_cast<World::Index>(i), static_cast<NPC::Type>(types[i]),
+                        positions[i], alive[i] != 0);
+        }
+    });
+    if (corrupt.load()) {
+        world.clear();
+        throw std::runtime_error("checkpoint '" + path + "' holds an invalid NPC");
+    }
+    world.reindex();
+
+    CheckpointState state;
+    state.seed = header.seed;
+    state.tick = header.tick;
+    state.combatSerial = header.combatSerial;
+    state.combatsResolved = header.combatsResolved;
+    state.kills = header.kills;
+    state.mapSize = header.mapSize;
+    return state;
+}
+
+CheckpointWriter::~CheckpointWriter() {
+    stop();
+}
+
+void CheckpointWriter::start(const std::string& path) {
+    stop();
+
+    // Fail now rather than on the first background write
+    std::string temporary = path + ".tmp";
+    int fd = ::open(temporary.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) throw std::runtime_error(systemError("cannot create checkpoint", temporary));
+    ::close(fd);
+    ::unlink(temporary.c_str());
+
+    path_ = path;
+    error_.clear();
+    stopping_ = false;
+    thread_ = std::thread(&CheckpointWriter::writeLoop, this);
+}
+
+void CheckpointWriter::stop() {
+    if (!thread_.joinable()) return;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    cv_.notify_all();
+    thread_.join();
+}
+
+bool CheckpointWriter::submit(const World& world, const CheckpointState& state, bool wait) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (!thread_.joinable()) return false;
+    if (pending_ && !wait) {
+        skipped_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    cv_.wait(lock, [this] { return !pending_; });
+
+    size_t count = world.size();
+    std::memcpy(header_.magic, kCheckpointMagic, sizeof(kCheckpointMagic));
+    header_.version = kCheckpointVersion;
+    header_.headerSize = sizeof(CheckpointHeader);
+    header_.count = count;
+    header_.seed = state.seed;
+    header_.tick = state.tick;
+    header_.combatSerial = state.combatSerial;
+    header_.combatsResolved = state.combatsResolved;
+    header_.kills = state.kills;
+    header_.mapSize = state.mapSize;
+    header_.typeCount = NPC::kTypeCount;
+
+    positions_.resize(count);
+    types_.resize(count);
+    alive_.resize(count);
+    for (World::Index i = 0; i < count; ++i) {
+        positions_[i] = world.packedPosition(i);
+        types_[i] = static_cast<uint8_t>(world.type(i));
+        alive_[i] = world.isAlive(i) ? 1 : 0;
+    }
+
+    pending_ = true;
+    lock.unlock();
+    cv_.notify_all();
+    return true;
+}
+
+std::string CheckpointWriter::lastError() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return error_;
+}
+
+void CheckpointWriter::writeLoop() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+        cv_.wait(lock, [this] { return pending_ || stopping_; });
+        if (!pending_) return;
+
+        // submit() leaves the buffers alone while pending_ is set
+        lock.unlock();
+        writeFile();
+        lock.lock();
+        pending_ = false;
+        cv_.notify_all();
+    }
+}
+
+void CheckpointWriter::writeFile() {
+    std::string temporary = path_ + ".tmp";
+    std::string failure;
+
+    int fd = ::open(temporary.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        failure = systemError("cannot create checkpoint", temporary);
+    } else {
+        bool ok = writeAll(fd, &header_, sizeof(header_)) &&
+                  writeAll(fd, positions_.data(), positions_.size() * sizeof(uint64_t)) &&
+                  writeAll(fd, types_.data(), types_.size()) &&
+                  writeAll(fd, alive_.data(), alive_.size()) &&
+                  ::fsync(fd) == 0;
+        if (!ok) failure = systemError("cannot write checkpoint", temporary);
+        if (::close(fd) != 0 && ok) failure = systemError("cannot write checkpoint", temporary);
+
+        if (failure.empty() && std::rename(temporary.c_str(), path_.c_str()) != 0) {
+            failure = systemError("cannot replace checkpoint", path_);
+        }
+        if (!failure.empty()) ::unlink(temporary.c_str());
+    }
+
+    if (failure.empty()) {
+        written_.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    error_ = failure;
+}
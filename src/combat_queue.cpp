@@ -0,0 +1,116 @@
+#include "../include/combat_queue.h"
+#include <algorithm>
+
+CombatQueue::CombatQueue(size_t capacity) {
+    size_t size = 2;
+    while (size < capacity) size <<= 1;
+    mask_ = size - 1;
+
+    slots_ = std::make_unique<Slot[]>(size);
+    for (size_t i = 0; i < size; ++i) {
+        slots_[i].sequence.store(i, std::memory_order_relaxed);
+    }
+}
+
+size_t CombatQueue::pushBatch(const CombatEvent* events, size_t count, size_t* position) {
+    size_t pos = enqueuePos_.load(std::memory_order_relaxed);
+    size_t claimed;
+
+    while (true) {
+        // A slot is free once its sequence equals the position writing it
+        claimed = 0;
+        while (claimed < count && claimed <= mask_ &&
+               slots_[(pos + claimed) & mask_].sequence.load(std::memory_order_acquire) == pos + claimed) {
+            ++claimed;
+        }
+        if (claimed == 0) return 0;
+
+        if (enqueuePos_.compare_exchange_weak(pos, pos + claimed, std::memory_order_relaxed)) {
+            break;
+        }
+    }
+
+    for (size_t i = 0; i < claimed; ++i) {
+        Slot& slot = slots_[(pos + i) & mask_];
+        slot.event = events[i];
+        slot.sequence.store(pos + i + 1, std::memory_order_release);
+    }
+    if (position) *position = pos;
+
+    wakeConsumer();
+    return claimed;
+}
+
+size_t CombatQueue::popBatch(CombatEvent* out, size_t maxCount, size_t* position) {
+    size_t pos = dequeuePos_.load(std::memory_order_relaxed);
+    size_t claimed;
+
+    while (true) {
+        // A slot is readable once its producer bumped the sequence past pos
+        claimed = 0;
+        while (claimed < maxCount && claimed <= mask_ &&
+               slots_[(pos + claimed) & mask_].sequence.load(std::memory_order_acquire) == pos + claimed + 1) {
+            ++claimed;
+        }
+        if (claimed == 0) return 0;
+
+        if (dequeuePos_.compare_exchange_weak(pos, pos + claimed, std::memory_order_relaxed)) {
+            break;
+        }
+    }
+
+    for (size_t i = 0; i < claimed; ++i) {
+        Slot& slot = slots_[(pos + i) & mask_];
+        out[i] = slot.event;
+        slot.sequence.store(pos + i + mask_ + 1, std::memory_order_release);
+    }
+    if (position) *position = pos;
+    return claimed;
+}
+
+bool CombatQueue::wait() {
+    waiters_.fetch_add(1, std::memory_order_seq_cst);
+
+    std::unique_lock<std::mutex> lock(waitMutex_);
+    waitCV_.wait(lock, [this] { return closed_ || !empty(); });
+    bool open = !closed_;
+
+    waiters_.fetch_sub(1, std::memory_order_relaxed);
+    return open || !empty();
+}
+
+void CombatQueue::close() {
+    {
+        std::lock_guard<std::mutex> lock(waitMutex_);
+        closed_ = true;
+    }
+    waitCV_.notify_all();
+}
+
+void CombatQueue::reopen() {
+    std::lock_guard<std::mutex> lock(waitMutex_);
+    closed_ = false;
+}
+
+bool CombatQueue::empty() const {
+    size_t pos = dequeuePos_.load(std::memory_order_acquire);
+    return slots_[pos & mask_].sequence.load(std::memory_order_acquire) != pos + 1;
+}
+
+size_t CombatQueue::size() const {
+    size_t head = dequeuePos_.load(std::memory_order_relaxed);
+    size_t tail = enqueuePos_.load(std::memory_order_relaxed);
+    return tail > head ? tail - head : 0;
+}
+
+void CombatQueue::wakeConsumer() {
+    // An RMW always reads the latest waiter count, so it pairs with the
+    // increment in wait(): either the consumer sees the new events in its
+    // predicate, or we see it waiting and notify. Costs one RMW per batch.
+    if (waiters_.fetch_add(0, std::memory_order_seq_cst) == 0) return;
+
+    {
+        std::lock_guard<std::mutex> lock(waitMutex_);
+    }
+    waitCV_.notify_one();
+}
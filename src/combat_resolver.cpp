@@ -0,0 +1,51 @@
+#include "../include/combat_resolver.h"
+#include <algorithm>
+
+void CombatResolver::schedule(const CombatEvent* events, size_t count, size_t npcCount) {
+    if (lastRound_.size() < npcCount) {
+        lastRound_.resize(npcCount);
+        stamp_.resize(npcCount, batch_);
+    }
+    if (++batch_ == 0) {
+        // Stamp wrapped; old stamps could alias the new batch
+        std::fill(stamp_.begin(), stamp_.end(), 0);
+        batch_ = 1;
+    }
+
+    auto roundOf = [this](uint32_t npc) {
+        return stamp_[npc] == batch_ ? lastRound_[npc] + 1 : 0;
+    };
+
+    eventRound_.resize(count);
+    uint32_t rounds = 0;
+    for (size_t i = 0; i < count; ++i) {
+        const CombatEvent& event = events[i];
+        uint32_t round = std::max(roundOf(event.attacker), roundOf(event.defender));
+
+        eventRound_[i] = round;
+        lastRound_[event.attacker] = round;
+        lastRound_[event.defender] = round;
+        stamp_[event.attacker] = batch_;
+        stamp_[event.defender] = batch_;
+        rounds = std::max(rounds, round + 1);
+    }
+
+    // Stable counting sort of events by round
+    roundStart_.assign(rounds + 1, 0);
+    for (size_t i = 0; i < count; ++i) {
+        ++roundStart_[eventRound_[i] + 1];
+    }
+    for (uint32_t r = 0; r < rounds; ++r) {
+        roundStart_[r + 1] += roundStart_[r];
+    }
+
+    order_.resize(count);
+    for (size_t i = 0; i < count; ++i) {
+        // roundStart_ doubles as the insertion cursor and is restored below
+        order_[roundStart_[eventRound_[i]]++] = static_cast<uint32_t>(i);
+    }
+    for (uint32_t r = rounds; r > 0; --r) {
+        roundStart_[r] = roundStart_[r - 1];
+    }
+    roundStart_[0] = 0;
+}
@@ -0,0 +1,186 @@
+#include "../include/event_log.h"
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <stdexcept>
+
+namespace {
+std::atomic<uint64_t> nextLogId{1};
+
+// One cached ring per thread, tagged with the log it belongs to
+struct RingCache {
+    uint64_t logId = 0;
+    void* ring = nullptr;
+};
+thread_local RingCache ringCache;
+
+constexpr char kBinaryMagic[8] = {'L', '7', 'C', 'L', 'O', 'G', '\0', '\1'};
+
+void appendNumber(std::string& out, uint64_t value) {
+    char buffer[24];
+    auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+    out.append(buffer, result.ptr);
+}
+}
+
+EventLog::EventLog(const World& world, std::ostream& out, std::mutex& outMutex, Profiler& profiler)
+    : world_(world), out_(out), outMutex_(outMutex), profiler_(profiler), id_(nextLogId++) {}
+
+EventLog::~EventLog() {
+    stop();
+    for (size_t i = 0; i < ringCount_.load(); ++i) {
+        delete rings_[i].load();
+    }
+}
+
+void EventLog::start(LogLevel level, LogFormat format, const std::string& binaryPath) {
+    stop();
+
+    format_ = format;
+    if (level != LogLevel::Off && format == LogFormat::Binary) {
+        binary_.open(binaryPath, std::ios::binary | std::ios::trunc);
+        if (!binary_) {
+            throw std::runtime_error("cannot open combat log '" + binaryPath + "'");
+        }
+        uint32_t recordSize = sizeof(CombatRecord);
+        binary_.write(kBinaryMagic, sizeof(kBinaryMagic));
+        binary_.write(reinterpret_cast<const char*>(&recordSize), sizeof(recordSize));
+    }
+
+    level_.store(level, std::memory_order_relaxed);
+    if (level == LogLevel::Off) return;
+
+    stopping_ = false;
+    drainThread_ = std::thread(&EventLog::drainLoop, this);
+}
+
+void EventLog::stop() {
+    level_.store(LogLevel::Off, std::memory_order_relaxed);
+    if (drainThread_.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(wakeMutex_);
+            stopping_ = true;
+        }
+        wakeCV_.notify_all();
+        drainThread_.join();
+    }
+    if (binary_.is_open()) binary_.close();
+}
+
+void EventLog::logCombat(const CombatRecord& record) {
+    Ring* ring = localRing();
+    if (ring == nullptr) {
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    size_t tail = ring->tail.load(std::memory_order_relaxed);
+    if (tail - ring->head.load(std::memory_order_acquire) == kRingSize) {
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    ring->records[tail % kRingSize] = record;
+    ring->tail.store(tail + 1, std::memory_order_release);
+}
+
+EventLog::Ring* EventLog::localRing() {
+    if (ringCache.logId == id_) return static_cast<Ring*>(ringCache.ring);
+
+    // Slow path, once per thread: find this thread's ring or register one
+    std::lock_guard<std::mutex> lock(registerMutex_);
+    std::thread::id self = std::this_thread::get_id();
+    size_t count = ringCount_.load(std::memory_order_relaxed);
+
+    Ring* ring = nullptr;
+    for (size_t i = 0; i < count && ring == nullptr; ++i) {
+        Ring* candidate = rings_[i].load(std::memory_order_relaxed);
+        if (candidate->owner == self) ring = candidate;
+    }
+    if (ring == nullptr) {
+        if (count == kMaxRings) return nullptr;
+        ring = new Ring();
+        ring->owner = self;
+        rings_[count].store(ring, std::memory_order_release);
+        ringCount_.store(count + 1, std::memory_order_release);
+    }
+
+    ringCache.logId = id_;
+    ringCache.ring = ring;
+    return ring;
+}
+
+void EventLog::drainLoop() {
+    while (true) {
+        bool stopping;
+        {
+            std::unique_lock<std::mutex> lock(wakeMutex_);
+            wakeCV_.wait_for(lock, std::chrono::milliseconds(20), [this] { return stopping_; });
+            stopping = stopping_;
+        }
+
+        drainOnce();
+        if (stopping) {
+            // Writers are done by now; pick up anything logged meanwhile
+            while (drainOnce() > 0) {}
+            return;
+        }
+    }
+}
+
+size_t EventLog::drainOnce() {
+    pending_.clear();
+
+    size_t count = ringCount_.load(std::memory_order_acquire);
+    for (size_t i = 0; i < count; ++i) {
+        Ring* ring = rings_[i].load(std::memory_order_acquire);
+        size_t head = ring->head.load(std::memory_order_relaxed);
+        size_t tail = ring->tail.load(std::memory_order_acquire);
+        for (size_t k = head; k < tail; ++k) {
+            pending_.push_back(ring->records[k % kRingSize]);
+        }
+        ring->head.store(tail, std::memory_order_release);
+    }
+
+    if (!pending_.empty()) {
+        // Each ring is in order; merge them by tick. Sorting indices by
+        // (tick, drain position) is stable without stable_sort's buffer.
+        order_.resize(pending_.size());
+        for (uint32_t k = 0; k < order_.size(); ++k) order_[k] = k;
+        std::sort(order_.begin(), order_.end(), [this](uint32_t a, uint32_t b) {
+            return pending_[a].tick != pending_[b].tick ? pending_[a].tick < pending_[b].tick : a < b;
+        });
+        
+        sorted_.resize(pending_.size());
+        for (size_t k = 0; k < order_.size(); ++k) sorted_[k] = pending_[order_[k]];
+        write(sorted_);
+    }
+    return pending_.size();
+}
+
+void EventLog::write(const std::vector<CombatRecord>& records) {
+    if (format_ == LogFormat::Binary) {
+        binary_.write(reinterpret_cast<const char*>(records.data()),
+                      static_cast<std::streamsize>(records.size() * sizeof(CombatRecord)));
+        return;
+    }
+
+    // Format outside the console lock, then write in one go
+    text_.clear();
+    for (const auto& record : records) {
+        std::string_view defender = world_.name(record.defender);
+        text_ += "\n[COMBAT] ";
+        text_ += world_.name(record.attacker);
+        text_ += " vs ";
+        text_ += defender;
+        text_ += "\n  Attack: ";
+        appendNumber(text_, record.attackRoll);
+        text_ += " vs Defense: ";
+        appendNumber(text_, record.defenseRoll);
+        text_ += "\n  Result: ";
+        text_ += defender;
+        text_ += record.killed ? " was killed!\n" : " defended successfully!\n";
+    }
+
+    ProfiledLock<std::unique_lock<std::mutex>> lock(profiler_, LockSite::Cout, outMutex_);
+    out_ << text_ << std::flush;
+}
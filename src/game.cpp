@@ -1,18 +1,84 @@
 #include "../include/game.h"
-#include "../include/knight.h"
-#include "../include/squirrel.h"
-#include "../include/pegasus.h"
+#include "../include/pair_kernel.h"
+#include <iomanip>
+#include <numeric>
 #include <iostream>
 #include <random>
 #include <chrono>
 #include <algorithm>
+#include <stdexcept>
 
-Game::Game(int mapSize, int npcCount, int duration)
-    : mapSize_(mapSize), npcCount_(npcCount), duration_(duration), running_(false) {}
+namespace {
+// NPCs per work-stealing chunk in the parallel phases
+constexpr size_t kMoveGrain = 4096;
+constexpr size_t kDetectGrain = 1024;
+
+// Events the combat thread drains from the queue per pop
+constexpr size_t kCombatBatch = 1024;
+
+// Interactive pacing: each type moves every movePeriodMs, map printed
+// once per second
+constexpr auto kPrintPeriod = std::chrono::seconds(1);
+
+// Finest step that lands on every type's move period
+std::chrono::milliseconds tickPeriod() {
+    int period = 0;
+    for (const auto& traits : kNPCTraits) {
+        period = std::gcd(period, std::max(1, traits.movePeriodMs));
+    }
+    return std::chrono::milliseconds(period);
+}
+
+// Config for the positional constructor. Fields are set by name, so new
+// GameConfig fields keep their defaults.
+GameConfig legacyConfig(int mapSize, int npcCount, int duration, unsigned threads) {
+    GameConfig config;
+    config.mapSize = mapSize;
+    config.npcCount = npcCount;
+    config.duration = duration;
+    config.threads = threads;
+    return config;
+}
+
+// Grid cell size and shard halo: every pair in range is at most this far apart
+int maxKillRange() {
+    int range = 1;
+    for (const auto& traits : kNPCTraits) {
+        range = std::max(range, traits.killRange);
+    }
+    return range;
+}
+}
+
+Game::Game(const GameConfig& config)
+    : mapSize_(config.mapSize), npcCount_(config.npcCount), duration_(config.duration),
+      seed_(config.seed != 0 ? config.seed : std::random_device{}()), verbose_(true),
+      logLevel_(config.logLevel), logFormat_(config.logFormat), logPath_(config.logPath),
+      viewportSize_(config.viewportSize), heatmapSize_(config.heatmapSize),
+      profile_(config.profile || !config.tracePath.empty()), profileInterval_(config.profileInterval),
+      tracePath_(config.tracePath), traceStart_(config.traceStart), traceTicks_(config.traceTicks),
+      checkpointPath_(config.checkpointPath), checkpointEvery_(config.checkpointEvery),
+      restorePath_(config.restorePath),
+      combatQueue_(config.combatQueueCapacity), overflowPolicy_(config.overflowPolicy),
+      resolvedPosition_(0), combatBusy_(false), eventsPublished_(0), eventsDeduplicated_(0),
+      eventsDropped_(0), eventsCoalesced_(0),
+      detectionMode_(DetectionMode::Sharded), eventLog_(world_, std::cout, coutMutex_, profiler_),
+      running_(false), tick_(0), combatsResolved_(0), kills_(0), pool_(config.threads),
+      combatPool_(config.combatThreads), headlessSerial_(0), serialBase_(0) {
+    if (mapSize_ <= 0 || npcCount_ < 0) {
+        throw std::invalid_argument("map size must be positive and NPC count non-negative");
+    }
+    shards_.configure(mapSize_, maxKillRange());
+}
+
+Game::Game(int mapSize, int npcCount, int duration, unsigned threads)
+    : Game(legacyConfig(mapSize, npcCount, duration, threads)) {}
 
 Game::~Game() {
     running_ = false;
-    combatCV_.notify_all();
+    tickScheduler_.stop();
+    printScheduler_.stop();
+    combatQueue_.close();
     
     if (movementThread_.joinable()) movementThread_.join();
     if (combatThread_.joinable()) combatThread_.join();
@@ -23,255 +89,697 @@ void Game::run() {
     initializeNPCs();
     
     running_ = true;
+    combatQueue_.reopen();
+    startProfiler();
+    eventLog_.start(logLevel_, logFormat_, logPath_);
+    
+    // One task per type marks it due; the tick task, added last, runs
+    // after them in a shared slot and moves only the types that are due
+    tickScheduler_.reset();
+    dueTypes_ = 0;
+    for (size_t t = 0; t < NPC::kTypeCount; ++t) {
+        auto type = static_cast<NPC::Type>(t);
+        tickScheduler_.every(std::chrono::milliseconds(npcTraits(type).movePeriodMs),
+                             [this, type] { dueTypes_ |= typeBit(type); });
+    }
+    tickScheduler_.every(tickPeriod(), [this] {
+        if (dueTypes_ == 0) return;
+        simulateTick(dueTypes_);
+        dueTypes_ = 0;
+    });
+    printScheduler_.reset();
+    printScheduler_.every(kPrintPeriod, [this] { printMap(); });
+    if (profile_) {
+        printScheduler_.every(std::chrono::seconds(std::max(1, profileInterval_)), [this] {
+            ProfiledLock<std::unique_lock<std::mutex>> coutLock(profiler_, LockSite::Cout, coutMutex_);
+            profiler_.dump(std::cout);
+        });
+    }
     
     // Start threads
-    movementThread_ = std::thread(&Game::movementThread, this);
+    movementThread_ = std::thread(&Scheduler::run, &tickScheduler_);
     combatThread_ = std::thread(&Game::combatThread, this);
-    printThread_ = std::thread(&Game::printThread, this);
+    printThread_ = std::thread(&Scheduler::run, &printScheduler_);
     
     // Run for specified duration
     std::this_thread::sleep_for(std::chrono::seconds(duration_));
     
-    // Stop threads
+    // Stop threads; the schedulers wake at once rather than at their next task
     running_ = false;
-    combatCV_.notify_all();
+    tickScheduler_.stop();
+    printScheduler_.stop();
+    combatQueue_.close();
     
     // Wait for threads to finish
     if (movementThread_.joinable()) movementThread_.join();
     if (combatThread_.joinable()) combatThread_.join();
     if (printThread_.joinable()) printThread_.join();
+    eventLog_.stop();
+    saveCheckpoint(tick_.load(std::memory_order_relaxed), true);
+    
+    // Combats resolved after the last tick's snapshot; publish the final state
+    snapshots_.publish(world_, tick_.load(std::memory_order_relaxed), mapSize_);
+    auto last = snapshots_.acquire();
     
     // Print final statistics
-    std::lock_guard<std::mutex> lock(coutMutex_);
+    ProfiledLock<std::unique_lock<std::mutex>> lock(profiler_, LockSite::Cout, coutMutex_);
     std::cout << "\n=== Game Over ===\n";
     
-    int alive = 0;
-    std::shared_lock<std::shared_mutex> readLock(npcsMutex_);
-    for (const auto& npc : npcs_) {
-        if (npc->isAlive()) {
-            alive++;
+    // Snapshot indices are ascending, so one cursor walks the survivors
+    size_t next = 0;
+    for (World::Index i = 0; i < last->total; ++i) {
+        if (next < last->alive() && last->indices[next] == i) {
             int x, y;
-            npc->getPosition(x, y);
-            std::cout << npc->getName() << " (" << NPC::typeToString(npc->getType()) 
+            World::unpack(last->positions[next], x, y);
+            std::cout << world_.name(i) << " (" << NPC::typeToString(last->types[next]) 
                      << ") survived at (" << x << ", " << y << ")\n";
+            ++next;
         } else {
-            std::cout << npc->getName() << " (" << NPC::typeToString(npc->getType()) 
+            std::cout << world_.name(i) << " (" << NPC::typeToString(world_.type(i)) 
                      << ") was killed\n";
         }
     }
-    std::cout << "\nSurvivors: " << alive << " / " << npcs_.size() << "\n";
+    std::cout << "\nSurvivors: " << last->alive() << " / " << last->total << "\n";
+    
+    CombatQueueStats stats = combatQueueStats();
+    std::cout << "Combat events: " << stats.published << " published, "
+              << stats.deduplicated << " deduplicated, " << stats.dropped << " dropped, "
+              << stats.coalesced << " coalesced\n";
+    if (eventLog_.dropped() > 0) {
+        std::cout << "Combat log records dropped: " << eventLog_.dropped() << "\n";
+    }
+    if (!checkpointPath_.empty()) {
+        std::cout << "Checkpoints: " << checkpoints_.written() << " written, "
+                  << checkpoints_.skipped() << " skipped while busy\n";
+        std::string error = checkpoints_.lastError();
+        if (!error.empty()) std::cout << "Checkpoint write failed: " << error << "\n";
+    }
+    profiler_.dump(std::cout);
+    lock.unlock();
+    
+    if (!tracePath_.empty()) profiler_.writeTrace(tracePath_);
 }
 
-void Game::initializeNPCs() {
-    std::random_device rd;
-    std::mt19937 gen(rd());
-    std::uniform_int_distribution<> posDist(0, mapSize_ - 1);
-    std::uniform_int_distribution<> typeDist(0, 2); // 0=Knight, 1=Squirrel, 2=Pegasus
+void Game::startProfiler() {
+    if (!profile_) return;
+    profiler_.start(traceStart_, tracePath_.empty() ? 0 : traceTicks_);
+}
 
-    int knightCount = 0, squirrelCount = 0, pegasusCount = 0;
+HeadlessResult Game::runHeadless(int ticks) {
+    verbose_ = false;
+    headlessSerial_ = 0;
+    initializeNPCs();
     
-    for (int i = 0; i < npcCount_; ++i) {
-        int x = posDist(gen);
-        int y = posDist(gen);
-        
-        NPCPtr npc;
-        int typeRoll = typeDist(gen);
-        switch (typeRoll) {
-            case 0: {
-                std::string name = "Knight_" + std::to_string(++knightCount);
-                npc = std::make_shared<Knight>(name, x, y);
-                break;
-            }
-            case 1: {
-                std::string name = "Squirrel_" + std::to_string(++squirrelCount);
-                npc = std::make_shared<Squirrel>(name, x, y);
-                break;
-            }
-            case 2:
-            default: {
-                std::string name = "Pegasus_" + std::to_string(++pegasusCount);
-                npc = std::make_shared<Pegasus>(name, x, y);
-                break;
-            }
+    HeadlessResult result;
+    startProfiler();
+    eventLog_.start(logLevel_, logFormat_, logPath_);
+    uint64_t combatsBefore = combatsResolved_;
+    uint64_t killsBefore = kills_;
+    auto start = std::chrono::steady_clock::now();
+    
+    for (int tick = 0; tick < ticks; ++tick) {
+        result.npcUpdates += headlessTick();
+    }
+    
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    eventLog_.stop();
+    saveCheckpoint(tick_.load(std::memory_order_relaxed), true);
+    std::string checkpointError = checkpoints_.lastError();
+    if (!checkpointError.empty()) std::cerr << "Checkpoint write failed: " << checkpointError << "\n";
+    result.ticks = ticks;
+    result.seconds = std::chrono::duration<double>(elapsed).count();
+    result.combatsResolved = combatsResolved_ - combatsBefore;
+    result.kills = kills_ - killsBefore;
+    snapshots_.publish(world_, tick_.load(std::memory_order_relaxed), mapSize_);
+    auto last = snapshots_.acquire();
+    result.survivors = last->alive();
+    // FNV-1a over the final state, to compare runs across thread counts
+    result.checksum = 0xcbf29ce484222325ull;
+    for (size_t i = 0; i < last->alive(); ++i) {
+        for (uint64_t value : {uint64_t{last->indices[i]}, last->positions[i]}) {
+            result.checksum = (result.checksum ^ value) * 0x100000001b3ull;
         }
+    }
+    
+    // stdout carries the JSON result
+    profiler_.dump(std::cerr);
+    if (!tracePath_.empty()) profiler_.writeTrace(tracePath_);
+    return result;
+}
+
+GameOutcome Game::playOut(uint64_t seed, int maxTicks) {
+    verbose_ = false;
+    seed_ = seed;
+    tick_.store(0, std::memory_order_relaxed);
+    headlessSerial_ = 0;
+    for (auto& cell : killMatrix_) cell.store(0, std::memory_order_relaxed);
+    initializeNPCs();
+    
+    GameOutcome outcome;
+    outcome.extinctionTick.fill(-1);
+    uint32_t alive = 0;
+    for (size_t t = 0; t < NPC::kTypeCount; ++t) {
+        outcome.survivors[t] = world_.aliveOfType(static_cast<NPC::Type>(t));
+        alive += outcome.survivors[t];
+    }
+    
+    while (outcome.ticks < maxTicks && alive > 1) {
+        headlessTick();
+        ++outcome.ticks;
         
-        npcs_.push_back(npc);
+        alive = 0;
+        for (size_t t = 0; t < NPC::kTypeCount; ++t) {
+            uint32_t left = world_.aliveOfType(static_cast<NPC::Type>(t));
+            // A type is wiped out on the tick its last NPC falls; types
+            // that were never placed have no extinction tick
+            if (left == 0 && outcome.survivors[t] > 0) outcome.extinctionTick[t] = outcome.ticks;
+            outcome.survivors[t] = left;
+            alive += left;
+        }
     }
     
-    std::lock_guard<std::mutex> lock(coutMutex_);
-    std::cout << "Initialized " << npcs_.size() << " NPCs on " << mapSize_ 
-              << "x" << mapSize_ << " map\n"
-              << "  Knights : " << knightCount << "\n"
-              << "  Squirrels: " << squirrelCount << "\n"
-              << "  Pegasus  : " << pegasusCount << "\n";
+    for (size_t c = 0; c < killMatrix_.size(); ++c) {
+        outcome.kills[c] = killMatrix_[c].load(std::memory_order_relaxed);
+    }
+    return outcome;
 }
 
-void Game::movementThread() {
-    while (running_) {
-        {
-            std::shared_lock<std::shared_mutex> readLock(npcsMutex_);
-            
-            // Move NPCs
-            for (auto& npc : npcs_) {
-                if (npc->isAlive()) {
-                    moveNPC(npc);
-                }
-            }
+size_t Game::headlessTick() {
+    uint64_t tick = tick_.fetch_add(1, std::memory_order_relaxed) + 1;
+    profiler_.beginTick(tick);
+    PhaseTimer tickTimer(profiler_, Phase::Tick);
+    compactWorld();
+    size_t moved;
+    {
+        ProfiledLock<std::shared_lock<std::shared_mutex>> readLock(profiler_, LockSite::Npcs, npcsMutex_);
+        moved = moveAll();
+        pairs_.clear();
+        findPairs(detectionMode_, pairs_);
+    }
+    
+    events_.clear();
+    for (const auto& pair : pairs_) {
+        events_.push_back({pair.first, pair.second});
+    }
+    resolveCombats(events_.data(), events_.size(), headlessSerial_);
+    headlessSerial_ += events_.size();
+    saveCheckpoint(tick, false);
+    return moved;
+}
+
+void Game::initializeNPCs() {
+    ProfiledLock<std::unique_lock<std::shared_mutex>> writeLock(profiler_, LockSite::Npcs, npcsMutex_);
+    serialBase_ = 0;
+    if (restorePath_.empty()) {
+        placeNPCs();
+    } else {
+        restoreNPCs();
+    }
+    shards_.configure(mapSize_, maxKillRange());
+    snapshots_.publish(world_, tick_.load(std::memory_order_relaxed), mapSize_);
+    writeLock.unlock();
+    
+    if (!checkpointPath_.empty()) checkpoints_.start(checkpointPath_);
+    
+    if (!verbose_) return;
+    
+    ProfiledLock<std::unique_lock<std::mutex>> lock(profiler_, LockSite::Cout, coutMutex_);
+    std::cout << (restorePath_.empty() ? "Initialized " : "Restored ") << world_.size()
+              << " NPCs on " << mapSize_ << "x" << mapSize_ << " map";
+    if (!restorePath_.empty()) std::cout << " at tick " << tick_.load(std::memory_order_relaxed);
+    std::cout << "\n";
+    for (size_t t = 0; t < NPC::kTypeCount; ++t) {
+        auto type = static_cast<NPC::Type>(t);
+        std::cout << "  " << std::left << std::setw(9) << npcTraits(type).name << std::right
+                  << ": " << world_.ofType(type).size() << "\n";
+    }
+}
+
+void Game::placeNPCs() {
+    world_.clear();
+    world_.resize(static_cast<size_t>(npcCount_));
+    
+    // Placement draws are keyed by NPC id, so NPCs are placed in parallel
+    // with the same result as a serial loop
+    pool_.parallelFor(0, world_.size(), kMoveGrain, [this](size_t begin, size_t end, unsigned) {
+        for (size_t i = begin; i < end; ++i) {
+            Philox::Counter words = randomWords(seed_, 0, static_cast<uint32_t>(i), RngPurpose::Placement);
+            int x = static_cast<int>(uniformBelow(words[0], static_cast<uint32_t>(mapSize_)));
+            int y = static_cast<int>(uniformBelow(words[1], static_cast<uint32_t>(mapSize_)));
+            auto type = static_cast<NPC::Type>(uniformBelow(words[2], NPC::kTypeCount));
+            world_.place(static_cast<World::Index>(i), type, World::pack(x, y), true);
         }
+    });
+    world_.reindex();
+}
+
+void Game::restoreNPCs() {
+    CheckpointState state = loadCheckpoint(restorePath_, world_, pool_);
+    seed_ = state.seed;
+    mapSize_ = state.mapSize;
+    npcCount_ = static_cast<int>(world_.size());
+    tick_.store(state.tick, std::memory_order_relaxed);
+    headlessSerial_ = state.combatSerial;
+    serialBase_ = state.combatSerial;
+    combatsResolved_.store(state.combatsResolved, std::memory_order_relaxed);
+    kills_.store(state.kills, std::memory_order_relaxed);
+}
+
+void Game::saveCheckpoint(uint64_t tick, bool final) {
+    if (checkpointPath_.empty()) return;
+    if (!final && (checkpointEvery_ == 0 || tick % checkpointEvery_ != 0)) return;
+    
+    // Alive flags and counters must match the positions of this tick, so
+    // every combat published so far is resolved before the copy
+    drainCombats();
+    ProfiledLock<std::shared_lock<std::shared_mutex>> readLock(profiler_, LockSite::Npcs, npcsMutex_);
+    
+    CheckpointState state;
+    state.seed = seed_;
+    state.tick = tick;
+    state.combatSerial = nextCombatSerial();
+    state.combatsResolved = combatsResolved_.load(std::memory_order_relaxed);
+    state.kills = kills_.load(std::memory_order_relaxed);
+    state.mapSize = mapSize_;
+    // Periodic saves are skipped while the last one is still on its way to
+    // disk; the final one waits and is written before returning
+    checkpoints_.submit(world_, state, final);
+    readLock.unlock();
+    if (final) checkpoints_.stop();
+}
+
+void Game::drainCombats() {
+    // This thread is the only producer, so once the ring is empty and the
+    // combat thread holds no popped batch, nothing can resolve until the
+    // next publish. Headless runs never queue, so this returns at once.
+    while (running_ && (!combatQueue_.empty() || combatBusy_.load(std::memory_order_seq_cst))) {
+        std::this_thread::yield();
+    }
+}
+
+uint64_t Game::nextCombatSerial() const {
+    // Headless ticks count serials themselves; the combat thread numbers
+    // events by ring position on top of the restored base. Whichever mode
+    // ran, the other value is still at the base.
+    return std::max(headlessSerial_, serialBase_ + resolvedPosition_.load(std::memory_order_acquire));
+}
+
+void Game::simulateTick(uint32_t types) {
+    uint64_t tick = tick_.fetch_add(1, std::memory_order_relaxed) + 1;
+    profiler_.beginTick(tick);
+    PhaseTimer tickTimer(profiler_, Phase::Tick);
+    compactWorld();
+    {
+        ProfiledLock<std::shared_lock<std::shared_mutex>> readLock(profiler_, LockSite::Npcs, npcsMutex_);
         
-        // Detect combats
-        detectCombats();
-        
-        // Small delay to prevent busy waiting
-        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        moveAll(types);
     }
+    
+    // Detect combats; parallelFor returning is the tick barrier. Publishing
+    // wakes the combat thread, so fights resolve as soon as they are found
+    detectCombats();
+    profiler_.recordQueueDepth(combatQueue_.size());
+    
+    // Positions only change on this thread, so the world is stable here
+    PhaseTimer snapshotTimer(profiler_, Phase::Snapshot);
+    snapshots_.publish(world_, tick, mapSize_);
+    saveCheckpoint(tick, false);
 }
 
-void Game::moveNPC(NPCPtr npc) {
-    static thread_local std::mt19937 gen(std::random_device{}());
-    static thread_local std::uniform_int_distribution<> dirDist(-1, 1);
+size_t Game::moveAll(uint32_t types) {
+    PhaseTimer timer(profiler_, Phase::Move);
+    std::atomic<size_t> moved{0};
+    uint64_t tick = tick_.load(std::memory_order_relaxed);
+    
+    // Walk NPCs grouped by type so each run gets a moveNPC specialised on
+    // its movement range. Steps come from the counter-based generator keyed
+    // by (seed, tick, NPC), generated a batch at a time, so the result does
+    // not depend on which worker moves which NPC.
+    pool_.parallelFor(0, world_.activeCount(), kMoveGrain,
+        [this, tick, types, &moved](size_t begin, size_t end, unsigned) {
+            size_t count = 0;
+            uint32_t words[4][kRandomBatch];
+            world_.forEachTypeRun(begin, end,
+                [&](auto tag, const World::Index* npcs, size_t runLength) {
+                    if (!(types & typeBit(decltype(tag)::value))) return;
+                    
+                    for (size_t base = 0; base < runLength; base += kRandomBatch) {
+                        size_t batch = std::min(kRandomBatch, runLength - base);
+                        randomWordsBatch(seed_, tick, npcs + base, batch, RngPurpose::Movement, words);
+                        
+                        for (size_t k = 0; k < batch; ++k) {
+                            if (!world_.isAlive(npcs[base + k])) continue;
+                            moveNPC<decltype(tag)::value>(npcs[base + k],
+                                {words[0][k], words[1][k], words[2][k], words[3][k]});
+                            ++count;
+                        }
+                    }
+                });
+            moved.fetch_add(count, std::memory_order_relaxed);
+        });
     
-    int range = npc->getMovementRange();
+    return moved;
+}
+
+template <NPC::Type T>
+void Game::moveNPC(World::Index npc, const Philox::Counter& words) {
+    constexpr uint32_t steps = TypeTraits<T>::movementRange + 1;
     
-    // Move by a random step within the movement range (avoiding modulo bias)
-    std::uniform_int_distribution<> stepDist(0, range);
-    int dx = dirDist(gen) * stepDist(gen);
-    int dy = dirDist(gen) * stepDist(gen);
+    // Direction in {-1, 0, 1} and a step within the movement range, per axis
+    int dx = (static_cast<int>(uniformBelow(words[0], 3)) - 1) * static_cast<int>(uniformBelow(words[1], steps));
+    int dy = (static_cast<int>(uniformBelow(words[2], 3)) - 1) * static_cast<int>(uniformBelow(words[3], steps));
     
     int currentX, currentY;
-    npc->getPosition(currentX, currentY);
+    world_.getPosition(npc, currentX, currentY);
     
     int newX = std::max(0, std::min(mapSize_ - 1, currentX + dx));
     int newY = std::max(0, std::min(mapSize_ - 1, currentY + dy));
     
-    npc->setPosition(newX, newY);
+    world_.setPosition(npc, newX, newY);
+}
+
+void Game::compactWorld() {
+    // Kills land between ticks, so the active lists only shrink here
+    if (!world_.compactionDue()) return;
+    ProfiledLock<std::unique_lock<std::shared_mutex>> writeLock(profiler_, LockSite::Npcs, npcsMutex_);
+    world_.compact();
 }
 
 void Game::detectCombats() {
-    std::shared_lock<std::shared_mutex> readLock(npcsMutex_);
+    ProfiledLock<std::shared_lock<std::shared_mutex>> readLock(profiler_, LockSite::Npcs, npcsMutex_);
+    
+    pairs_.clear();
+    findPairs(detectionMode_, pairs_);
     
-    for (size_t i = 0; i < npcs_.size(); ++i) {
-        if (!npcs_[i]->isAlive()) continue;
+    events_.clear();
+    for (const auto& pair : pairs_) {
+        events_.push_back({pair.first, pair.second});
+    }
+    readLock.unlock();
+    
+    publishCombats();
+}
+
+void Game::publishCombats() {
+    PhaseTimer timer(profiler_, Phase::Publish);
+    uint64_t stallStart = 0;
+    
+    // Forget pairs the combat thread has resolved
+    size_t resolved = resolvedPosition_.load(std::memory_order_acquire);
+    inFlightNext_.clear();
+    inFlight_.forEach([&](uint64_t key, uint64_t position) {
+        if (position >= resolved) inFlightNext_.insert(key, position);
+    });
+    std::swap(inFlight_, inFlightNext_);
+    
+    // Skip pairs whose event from an earlier tick is still queued
+    size_t kept = 0;
+    for (const auto& event : events_) {
+        if (inFlight_.contains(PairSet::key(event.attacker, event.defender))) {
+            eventsDeduplicated_.fetch_add(1, std::memory_order_relaxed);
+        } else {
+            events_[kept++] = event;
+        }
+    }
+    events_.resize(kept);
+    
+    // Overflow held back last tick is superseded by this tick's detection:
+    // pairs still in range coalesce, the rest are stale
+    if (!heldOverflow_.empty()) {
+        size_t matched = 0;
+        for (const auto& event : events_) {
+            if (heldOverflow_.contains(PairSet::key(event.attacker, event.defender))) ++matched;
+        }
+        eventsCoalesced_.fetch_add(matched, std::memory_order_relaxed);
+        eventsDropped_.fetch_add(heldOverflow_.size() - matched, std::memory_order_relaxed);
+        heldOverflow_.clear();
+    }
+    
+    // Publish the whole tick at once
+    size_t published = 0;
+    while (published < events_.size()) {
+        size_t position = 0;
+        size_t count = combatQueue_.pushBatch(events_.data() + published,
+                                              events_.size() - published, &position);
+        for (size_t i = 0; i < count; ++i) {
+            const auto& event = events_[published + i];
+            inFlight_.insert(PairSet::key(event.attacker, event.defender), position + i);
+        }
+        published += count;
+        eventsPublished_.fetch_add(count, std::memory_order_relaxed);
         
-        for (size_t j = i + 1; j < npcs_.size(); ++j) {
-            if (!npcs_[j]->isAlive()) continue;
-            
-            // Use squared distance to avoid expensive sqrt operation
-            int distanceSquared = npcs_[i]->distanceSquaredTo(*npcs_[j]);
-            
-            // Check if within either NPC's kill range
-            int maxKillRange = std::max(npcs_[i]->getKillRange(), npcs_[j]->getKillRange());
-            if (distanceSquared <= maxKillRange * maxKillRange) {
-                
-                // Add to combat queue
-                std::lock_guard<std::mutex> lock(combatQueueMutex_);
-                combatQueue_.push({npcs_[i], npcs_[j]});
-                combatCV_.notify_one();
+        size_t remaining = events_.size() - published;
+        if (remaining == 0) break;
+        
+        if (overflowPolicy_ == OverflowPolicy::Coalesce) {
+            for (size_t i = published; i < events_.size(); ++i) {
+                heldOverflow_.insert(PairSet::key(events_[i].attacker, events_[i].defender), 0);
+            }
+            break;
+        }
+        
+        if (overflowPolicy_ == OverflowPolicy::DropOldest) {
+            evicted_.resize(remaining);
+            size_t evictedPosition = 0;
+            size_t evicted = combatQueue_.popBatch(evicted_.data(), remaining, &evictedPosition);
+            eventsDropped_.fetch_add(evicted, std::memory_order_relaxed);
+            // Nothing is queued for these pairs any more, so detecting them
+            // again next tick must not count as a duplicate
+            for (size_t i = 0; i < evicted; ++i) {
+                uint64_t key = PairSet::key(evicted_[i].attacker, evicted_[i].defender);
+                const uint64_t* queuedAt = inFlight_.find(key);
+                if (queuedAt && *queuedAt == evictedPosition + i) inFlight_.erase(key);
             }
+            if (evicted > 0) continue;
+        } else if (!running_) {
+            // Nobody will drain the queue; blocking would never return
+            eventsDropped_.fetch_add(remaining, std::memory_order_relaxed);
+            break;
         }
+        
+        if (stallStart == 0 && profiler_.enabled()) stallStart = Profiler::now();
+        std::this_thread::yield();
     }
+    if (stallStart != 0) profiler_.recordPhase(Phase::QueueStall, stallStart, Profiler::now());
 }
 
-void Game::combatThread() {
-    while (running_) {
-        std::unique_lock<std::mutex> lock(combatQueueMutex_);
-        
-        // Wait for combat events or timeout
-        combatCV_.wait_for(lock, std::chrono::milliseconds(100), 
-            [this] { return !combatQueue_.empty() || !running_; });
-        
-        if (!combatQueue_.empty()) {
-            CombatEvent event = combatQueue_.front();
-            combatQueue_.pop();
-            lock.unlock();
+CombatQueueStats Game::combatQueueStats() const {
+    CombatQueueStats stats;
+    stats.published = eventsPublished_.load(std::memory_order_relaxed);
+    stats.deduplicated = eventsDeduplicated_.load(std::memory_order_relaxed);
+    stats.dropped = eventsDropped_.load(std::memory_order_relaxed);
+    stats.coalesced = eventsCoalesced_.load(std::memory_order_relaxed);
+    stats.queued = combatQueue_.size();
+    return stats;
+}
+
+std::vector<CombatPair> Game::findCombatPairs(DetectionMode mode) {
+    ProfiledLock<std::shared_lock<std::shared_mutex>> readLock(profiler_, LockSite::Npcs, npcsMutex_);
+    
+    std::vector<CombatPair> pairs;
+    findPairs(mode, pairs);
+    // Sharded reports pairs strip by strip; match the other modes' order
+    if (mode == DetectionMode::Sharded) std::sort(pairs.begin(), pairs.end());
+    return pairs;
+}
+
+void Game::findPairs(DetectionMode mode, std::vector<CombatPair>& out) {
+    PhaseTimer timer(profiler_, Phase::Detect);
+    if (mode == DetectionMode::BruteForce) {
+        findPairsBruteForce(out);
+    } else if (mode == DetectionMode::Sharded) {
+        findPairsSharded(out);
+    } else {
+        findPairsGrid(out);
+    }
+}
+
+void Game::findPairsBruteForce(std::vector<CombatPair>& out) {
+    gatherCandidates();
+    
+    // Every alive NPC against all later ones, 64 candidates per kernel call
+    size_t count = candX_.size();
+    for (size_t i = 0; i < count; ++i) {
+        for (size_t base = i + 1; base < count; base += 64) {
+            size_t run = std::min<size_t>(64, count - base);
+            uint64_t hits = rangeMask(candX_[i], candY_[i], candRange_[i], candX_.data() + base,
+                                      candY_.data() + base, candRange_.data() + base, run);
             
-            processCombat(event);
+            for (; hits != 0; hits &= hits - 1) {
+                out.emplace_back(candIndex_[i], candIndex_[base + __builtin_ctzll(hits)]);
+            }
         }
     }
 }
 
-bool Game::processCombat(const CombatEvent& event) {
-    // Check if both NPCs are still alive
-    if (!event.attacker->isAlive() || !event.defender->isAlive()) {
-        return false;
-    }
+void Game::findPairsGrid(std::vector<CombatPair>& out) {
+    gatherCandidates();
     
-    // Roll dice for attack and defense (d6)
-    int attackRoll = event.attacker->rollDice() + event.attacker->getAttackBonus();
-    int defenseRoll = event.defender->rollDice() + event.defender->getDefenseBonus();
+    size_t count = candX_.size();
+    grid_.rebuild(candX_.data(), candY_.data(), candRange_.data(), count, maxKillRange());
     
-    std::lock_guard<std::mutex> coutLock(coutMutex_);
+    // Each chunk writes its own list, so concatenating in chunk order keeps
+    // the pairs sorted no matter which worker ran which chunk
+    size_t chunks = (count + kDetectGrain - 1) / kDetectGrain;
+    if (chunkPairs_.size() < chunks) chunkPairs_.resize(chunks);
     
-    std::cout << "\n[COMBAT] " << event.attacker->getName() 
-              << " vs " << event.defender->getName() << "\n";
-    std::cout << "  Attack: " << attackRoll << " vs Defense: " << defenseRoll << "\n";
+    pool_.parallelFor(0, count, kDetectGrain,
+        [this](size_t begin, size_t end, unsigned) {
+            auto& pairs = chunkPairs_[begin / kDetectGrain];
+            pairs.clear();
+            grid_.findPairs(candX_.data(), candY_.data(), candRange_.data(),
+                            begin, end, pairs);
+        });
     
-    if (attackRoll > defenseRoll) {
-        event.defender->kill();
-        std::cout << "  Result: " << event.defender->getName() << " was killed!\n";
-        return true;
-    } else {
-        std::cout << "  Result: " << event.defender->getName() << " defended successfully!\n";
-        return false;
+    for (size_t c = 0; c < chunks; ++c) {
+        for (const auto& pair : chunkPairs_[c]) {
+            out.emplace_back(candIndex_[pair.first], candIndex_[pair.second]);
+        }
     }
 }
 
-void Game::printThread() {
-    while (running_) {
-        std::this_thread::sleep_for(std::chrono::seconds(1));
-        printMap();
-    }
+void Game::findPairsSharded(std::vector<CombatPair>& out) {
+    // Shards track membership themselves, so there is no global gather
+    shards_.findPairs(world_, pool_, out);
 }
 
-void Game::printMap() {
-    std::lock_guard<std::mutex> coutLock(coutMutex_);
-    std::shared_lock<std::shared_mutex> readLock(npcsMutex_);
+void Game::gatherCandidates() {
+    // Compact alive NPCs into dense arrays in two parallel passes: count per
+    // chunk, then fill at prefix-summed offsets so NPC order is preserved.
+    // Alive flags are sampled once, since combat may kill NPCs in between.
+    const auto& active = world_.active();
+    size_t total = active.size();
+    size_t chunks = (total + kMoveGrain - 1) / kMoveGrain;
+    chunkAlive_.assign(chunks + 1, 0);
+    aliveMask_.resize(total);
     
-    std::cout << "\n=== Map State ===\n";
+    pool_.parallelFor(0, total, kMoveGrain,
+        [this, &active](size_t begin, size_t end, unsigned) {
+            size_t alive = 0;
+            for (size_t i = begin; i < end; ++i) {
+                aliveMask_[i] = world_.isAlive(active[i]) ? 1 : 0;
+                alive += aliveMask_[i];
+            }
+            chunkAlive_[begin / kMoveGrain + 1] = alive;
+        });
     
-    // Create a simple map representation
-    std::vector<std::vector<char>> map(mapSize_, std::vector<char>(mapSize_, '.'));
+    for (size_t c = 0; c < chunks; ++c) {
+        chunkAlive_[c + 1] += chunkAlive_[c];
+    }
     
-    int aliveCount = 0;
-    for (const auto& npc : npcs_) {
-        if (npc->isAlive()) {
-            aliveCount++;
-            int x, y;
-            npc->getPosition(x, y);
-            
-            char symbol;
-            switch (npc->getType()) {
-                case NPC::Type::Knight: symbol = 'K'; break;
-                case NPC::Type::Squirrel: symbol = 'S'; break;
-                case NPC::Type::Pegasus: symbol = 'P'; break;
-                default: symbol = '?'; break;
-            }
-            
-            // If position already occupied, use '*' to indicate multiple NPCs
-            if (map[y][x] != '.') {
-                map[y][x] = '*';
-            } else {
-                map[y][x] = symbol;
+    size_t count = chunkAlive_[chunks];
+    candX_.resize(count);
+    candY_.resize(count);
+    candRange_.resize(count);
+    candIndex_.resize(count);
+    
+    pool_.parallelFor(0, total, kMoveGrain,
+        [this, &active](size_t begin, size_t end, unsigned) {
+            size_t slot = chunkAlive_[begin / kMoveGrain];
+            for (size_t i = begin; i < end; ++i) {
+                if (!aliveMask_[i]) continue;
+                
+                World::Index npc = active[i];
+                world_.getPosition(npc, candX_[slot], candY_[slot]);
+                candRange_[slot] = world_.killRange(npc);
+                candIndex_[slot] = npc;
+                ++slot;
             }
+        });
+}
+
+void Game::combatThread() {
+    std::vector<CombatEvent> batch(kCombatBatch);
+    
+    while (running_) {
+        // Raised before the pop, so drainCombats never sees an empty ring
+        // while a popped batch is still unresolved
+        combatBusy_.store(true, std::memory_order_seq_cst);
+        size_t position = 0;
+        size_t count = combatQueue_.popBatch(batch.data(), batch.size(), &position);
+        if (count == 0) {
+            combatBusy_.store(false, std::memory_order_seq_cst);
+            // Sleep until a producer publishes or the game stops
+            PhaseTimer idleTimer(profiler_, Phase::CombatIdle);
+            if (!combatQueue_.wait()) break;
+            continue;
         }
+        
+        // Ring positions number the events, so dice follow the queue order
+        resolveCombats(batch.data(), count, serialBase_ + position);
+        
+        // Lets detectCombats enqueue these pairs again
+        resolvedPosition_.store(position + count, std::memory_order_release);
+        combatBusy_.store(false, std::memory_order_seq_cst);
+    }
+    combatBusy_.store(false, std::memory_order_seq_cst);
+}
+
+void Game::resolveCombats(const CombatEvent* events, size_t count, uint64_t firstSerial) {
+    PhaseTimer timer(profiler_, Phase::Resolve);
+    resolver_.resolve(events, count, world_.size(), combatPool_,
+        [this, firstSerial](const CombatEvent& event, size_t index) {
+            processCombat(event, firstSerial + index);
+        });
+}
+
+bool Game::processCombat(const CombatEvent& event, uint64_t serial) {
+    // Check if both NPCs are still alive
+    if (!world_.isAlive(event.attacker) || !world_.isAlive(event.defender)) {
+        return false;
     }
     
-    // Print a sample of the map (center 20x20 area)
-    int startX = std::max(0, mapSize_ / 2 - 10);
-    int endX = std::min(mapSize_, mapSize_ / 2 + 10);
-    int startY = std::max(0, mapSize_ / 2 - 10);
-    int endY = std::min(mapSize_, mapSize_ / 2 + 10);
+    const auto& attacker = npcTraits(world_.type(event.attacker));
+    const auto& defender = npcTraits(world_.type(event.defender));
     
-    std::cout << "Center area (" << startX << "-" << endX << ", " 
-              << startY << "-" << endY << "):\n";
+    // Roll dice for attack and defense (d6)
+    int attackDie, defenseDie;
+    combatRolls(seed_, serial, attackDie, defenseDie);
+    int attackRoll = attackDie + attacker.attackBonus;
+    int defenseRoll = defenseDie + defender.defenseBonus;
     
-    for (int y = startY; y < endY; ++y) {
-        for (int x = startX; x < endX; ++x) {
-            std::cout << map[y][x] << ' ';
-        }
-        std::cout << '\n';
+    bool killed = attackRoll > defenseRoll;
+    
+    // Claim the kill with a CAS so concurrent resolvers can't both win
+    if (killed && !world_.tryKill(event.defender)) {
+        return false;
     }
     
-    std::cout << "\nAlive NPCs: " << aliveCount << " / " << npcs_.size() << "\n";
-    std::cout << "Legend: K=Knight, *=Multiple, .=Empty\n";
-}
\ No newline at end of file
+    combatsResolved_.fetch_add(1, std::memory_order_relaxed);
+    if (killed) {
+        kills_.fetch_add(1, std::memory_order_relaxed);
+        size_t cell = static_cast<size_t>(world_.type(event.attacker)) * NPC::kTypeCount +
+                      static_cast<size_t>(world_.type(event.defender));
+        killMatrix_[cell].fetch_add(1, std::memory_order_relaxed);
+    }
+    
+    if (eventLog_.wants(killed)) {
+        eventLog_.logCombat({tick_.load(std::memory_order_relaxed), event.attacker, event.defender,
+                             static_cast<uint8_t>(attackRoll), static_cast<uint8_t>(defenseRoll),
+                             static_cast<uint8_t>(killed), 0, 0});
+    }
+    return killed;
+}
+
+void Game::printMap() {
+    PhaseTimer timer(profiler_, Phase::Render);
+    // Readers pin the latest tick; nothing here blocks the simulation
+    auto snapshot = snapshots_.acquire();
+    if (!snapshot) return;
+    // Nothing has moved since the last frame
+    if (snapshot->tick == printedTick_) return;
+    printedTick_ = snapshot->tick;
+    
+    frame_.clear();
+    renderer_.renderViewport(*snapshot,
+                             Viewport::centred(mapSize_, viewportSize_, viewportSize_), frame_);
+    if (heatmapSize_ > 0) {
+        // Terminal cells are about twice as tall as wide
+        int rows = std::max(1, heatmapSize_ / 2);
+        renderer_.renderHeatmap(*snapshot, heatmapSize_, rows, HeatmapKind::Density, frame_);
+        renderer_.renderHeatmap(*snapshot, heatmapSize_, rows, HeatmapKind::Type, frame_);
+    }
+    
+    ProfiledLock<std::unique_lock<std::mutex>> coutLock(profiler_, LockSite::Cout, coutMutex_);
+    std::cout << frame_;
+}
@@ -1,4 +0,0 @@
-#include "../include/knight.h"
-
-Knight::Knight(const std::string& name, int x, int y)
-    : NPC(Type::Knight, name, x, y) {}
@@ -1,23 +1,267 @@
+#include "../include/batch_runner.h"
 #include "../include/game.h"
+#include "../include/pair_kernel.h"
+#include <cctype>
+#include <cstring>
 #include <iostream>
+#include <limits>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <sys/resource.h>
 
-int main() {
-    std::cout << "=== Laboratory Work #7: Asynchronous Programming ===\n";
-    std::cout << "Variant 4: Wandering Knight\n";
-    std::cout << "- Movement range: 30\n";
-    std::cout << "- Kill range: 10\n";
-    std::cout << "- Map size: 100x100\n";
-    std::cout << "- NPCs: 50\n";
-    std::cout << "- Duration: 30 seconds\n";
-    std::cout << "- Threads: 3 (movement+combat detection, combat, map printing)\n\n";
-    
+namespace {
+
+struct Options {
+    GameConfig config;
+    bool headless = false;
+    bool logLevelSet = false;
+    int ticks = 1000;
+    uint64_t batchGames = 0;
+};
+
+void printUsage(const char* program) {
+    std::cout << "Usage: " << program << " [--headless | --batch GAMES] [--map N] [--npcs N] [--ticks N]\n"
+              << "       [--seed N] [--threads N] [--combat-threads N] [--duration SECONDS]\n"
+              << "       [--queue-capacity N] [--overflow block|drop-oldest|coalesce]\n"
+              << "       [--log off|kills|combat] [--log-file PATH]\n"
+              << "       [--viewport N] [--heatmap COLUMNS]\n"
+              << "       [--profile] [--profile-interval SECONDS]\n"
+              << "       [--trace PATH] [--trace-start TICK] [--trace-ticks N]\n"
+              << "       [--checkpoint PATH] [--checkpoint-every TICKS] [--restore PATH]\n\n"
+              << "  --headless   run ticks back-to-back without sleeps or map output\n"
+              << "               and print throughput as JSON (combat log off by default)\n"
+              << "  --batch      play GAMES independent headless games of up to --ticks\n"
+              << "               ticks on --threads workers and print survival statistics\n"
+              << "               as JSON\n"
+              << "  --log-file   write the combat log as binary records to PATH\n"
+              << "  --profile    print per-phase, lock and queue-depth statistics\n"
+              << "               (to stderr in headless mode)\n"
+              << "  --trace      also write a Chrome trace of --trace-ticks ticks to PATH\n"
+              << "  --checkpoint save the world to PATH every --checkpoint-every ticks\n"
+              << "               (0 = only at the end) and when the run finishes\n"
+              << "  --restore    resume from a checkpoint; its seed, map and NPCs replace\n"
+              << "               --seed, --map and --npcs\n";
+}
+
+OverflowPolicy parseOverflowPolicy(const char* value) {
+    std::string policy = value ? value : "";
+    if (policy == "block") return OverflowPolicy::Block;
+    if (policy == "drop-oldest") return OverflowPolicy::DropOldest;
+    if (policy == "coalesce") return OverflowPolicy::Coalesce;
+    throw std::invalid_argument("--overflow expects block, drop-oldest or coalesce");
+}
+
+LogLevel parseLogLevel(const char* value) {
+    std::string level = value ? value : "";
+    if (level == "off") return LogLevel::Off;
+    if (level == "kills") return LogLevel::Kills;
+    if (level == "combat") return LogLevel::Combat;
+    throw std::invalid_argument("--log expects off, kills or combat");
+}
+
+// Non-negative integer that fits in T; anything else is rejected rather
+// than wrapped by a cast
+template <typename T>
+T parseNumber(const std::string& flag, const char* value) {
+    if (value == nullptr) {
+        throw std::invalid_argument(flag + " expects a value");
+    }
+    const std::string limit = std::to_string(std::numeric_limits<T>::max());
+    try {
+        size_t used = 0;
+        // stoull would accept a sign, so require a leading digit
+        if (!std::isdigit(static_cast<unsigned char>(value[0]))) throw std::invalid_argument(value);
+        unsigned long long number = std::stoull(value, &used);
+        if (used != std::strlen(value)) throw std::invalid_argument(value);
+        if (number > static_cast<unsigned long long>(std::numeric_limits<T>::max())) throw std::out_of_range(value);
+        return static_cast<T>(number);
+    } catch (const std::logic_error&) {
+        throw std::invalid_argument(flag + " expects an integer from 0 to " + limit + ", got '" + value + "'");
+    }
+}
+
+Options parseOptions(int argc, char* argv[]) {
+    Options options;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string flag = argv[i];
+        const char* value = i + 1 < argc ? argv[i + 1] : nullptr;
+
+        if (flag == "--headless") {
+            options.headless = true;
+            continue;
+        }
+        if (flag == "--profile") {
+            options.config.profile = true;
+            continue;
+        }
+
+        if (flag == "--map") options.config.mapSize = parseNumber<int>(flag, value);
+        else if (flag == "--npcs") options.config.npcCount = parseNumber<int>(flag, value);
+        else if (flag == "--batch") options.batchGames = parseNumber<uint64_t>(flag, value);
+        else if (flag == "--ticks") options.ticks = parseNumber<int>(flag, value);
+        else if (flag == "--seed") options.config.seed = parseNumber<uint64_t>(flag, value);
+        else if (flag == "--threads") options.config.threads = parseNumber<unsigned>(flag, value);
+        else if (flag == "--combat-threads") options.config.combatThreads = parseNumber<unsigned>(flag, value);
+        else if (flag == "--duration") options.config.duration = parseNumber<int>(flag, value);
+        else if (flag == "--queue-capacity") options.config.combatQueueCapacity = parseNumber<size_t>(flag, value);
+        else if (flag == "--overflow") options.config.overflowPolicy = parseOverflowPolicy(value);
+        else if (flag == "--viewport") options.config.viewportSize = parseNumber<int>(flag, value);
+        else if (flag == "--heatmap") options.config.heatmapSize = parseNumber<int>(flag, value);
+        else if (flag == "--profile-interval") options.config.profileInterval = parseNumber<int>(flag, value);
+        else if (flag == "--trace-start") options.config.traceStart = parseNumber<uint64_t>(flag, value);
+        else if (flag == "--trace-ticks") options.config.traceTicks = parseNumber<uint64_t>(flag, value);
+        else if (flag == "--trace") {
+            if (value == nullptr) throw std::invalid_argument(flag + " expects a path");
+            options.config.tracePath = value;
+        }
+        else if (flag == "--checkpoint-every") options.config.checkpointEvery = parseNumber<uint64_t>(flag, value);
+        else if (flag == "--checkpoint") {
+            if (value == nullptr) throw std::invalid_argument(flag + " expects a path");
+            options.config.checkpointPath = value;
+        }
+        else if (flag == "--restore") {
+            if (value == nullptr) throw std::invalid_argument(flag + " expects a path");
+            options.config.restorePath = value;
+        }
+        else if (flag == "--log") {
+            options.config.logLevel = parseLogLevel(value);
+            options.logLevelSet = true;
+        } else if (flag == "--log-file") {
+            if (value == nullptr) throw std::invalid_argument(flag + " expects a path");
+            options.config.logFormat = LogFormat::Binary;
+            options.config.logPath = value;
+        }
+        else throw std::invalid_argument("unknown option '" + flag + "'");
+        ++i;
+    }
+
+    if (options.headless && !options.logLevelSet) {
+        options.config.logLevel = LogLevel::Off;
+    }
+    return options;
+}
+
+long peakRssKb() {
+    struct rusage usage {};
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;  // kilobytes on Linux
+}
+
+void runHeadless(const Options& options) {
+    Game game(options.config);
+    HeadlessResult result = game.runHeadless(options.ticks);
+
+    double seconds = result.seconds > 0.0 ? result.seconds : 1e-9;
+
+    std::cout << "{\"mode\": \"headless\""
+              << ", \"map_size\": " << game.mapSize()
+              << ", \"npcs\": " << game.npcCount()
+              << ", \"ticks\": " << result.ticks
+              << ", \"seed\": " << game.seed()
+              << ", \"threads\": " << options.config.threads
+              << ", \"combat_threads\": " << options.config.combatThreads
+              << ", \"pair_kernel\": \"" << pairKernelName(activePairKernel()) << "\""
+              << ", \"seconds\": " << result.seconds
+              << ", \"ticks_per_sec\": " << result.ticks / seconds
+              << ", \"npc_updates_per_sec\": " << result.npcUpdates / seconds
+              << ", \"combats_resolved_per_sec\": " << result.combatsResolved / seconds
+              << ", \"combats_resolved\": " << result.combatsResolved
+              << ", \"kills\": " << result.kills
+              << ", \"survivors\": " << result.survivors
+              << ", \"checksum\": \"" << std::hex << result.checksum << std::dec << "\""
+              << ", \"peak_rss_kb\": " << peakRssKb()
+              << "}" << std::endl;
+}
+
+void runBatch(const Options& options) {
+    BatchConfig batch;
+    batch.games = options.batchGames;
+    batch.seed = options.config.seed != 0 ? options.config.seed : std::random_device{}();
+    batch.workers = options.config.threads;
+    batch.mapSize = options.config.mapSize;
+    batch.npcCount = options.config.npcCount;
+    batch.maxTicks = options.ticks;
+    BatchSummary summary = BatchRunner(batch).run();
+
+    double seconds = summary.seconds > 0.0 ? summary.seconds : 1e-9;
+    double games = summary.games > 0 ? static_cast<double>(summary.games) : 1.0;
+
+    std::cout << "{\"mode\": \"batch\""
+              << ", \"games\": " << summary.games
+              << ", \"map_size\": " << batch.mapSize
+              << ", \"npcs\": " << batch.npcCount
+              << ", \"max_ticks\": " << batch.maxTicks
+              << ", \"seed\": " << batch.seed
+              << ", \"workers\": " << batch.workers
+              << ", \"seconds\": " << summary.seconds
+              << ", \"games_per_sec\": " << summary.games / seconds
+              << ", \"mean_ticks\": " << summary.ticks / games
+              << ", \"types\": {";
+    for (size_t t = 0; t < NPC::kTypeCount; ++t) {
+        std::cout << (t ? ", " : "") << "\"" << npcTraits(static_cast<NPC::Type>(t)).name << "\": {"
+                  << "\"mean_survivors\": " << summary.survivors[t] / games
+                  << ", \"survival_rate\": " << summary.gamesSurvived[t] / games
+                  << ", \"extinctions\": " << summary.extinctionCount(t)
+                  << ", \"extinction_tick_mean\": " << summary.meanExtinctionTick(t)
+                  << ", \"extinction_tick_p50\": " << summary.extinctionPercentile(t, 0.5)
+                  << ", \"extinction_tick_p99\": " << summary.extinctionPercentile(t, 0.99) << "}";
+    }
+    // kills[attacker][defender]
+    std::cout << "}, \"kills\": {";
+    for (size_t a = 0; a < NPC::kTypeCount; ++a) {
+        std::cout << (a ? ", " : "") << "\"" << npcTraits(static_cast<NPC::Type>(a)).name << "\": {";
+        for (size_t d = 0; d < NPC::kTypeCount; ++d) {
+            std::cout << (d ? ", " : "") << "\"" << npcTraits(static_cast<NPC::Type>(d)).name << "\": "
+                      << summary.kills[a * NPC::kTypeCount + d];
+        }
+        std::cout << "}";
+    }
+    std::cout << "}, \"peak_rss_kb\": " << peakRssKb() << "}" << std::endl;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
     try {
-        Game game(100, 50, 30);
+        for (int i = 1; i < argc; ++i) {
+            if (std::strcmp(argv[i], "--help") == 0 || std::strcmp(argv[i], "-h") == 0) {
+                printUsage(argv[0]);
+                return 0;
+            }
+        }
+
+        Options options = parseOptions(argc, argv);
+        if (options.batchGames > 0) {
+            runBatch(options);
+            return 0;
+        }
+        if (options.headless) {
+            runHeadless(options);
+            return 0;
+        }
+
+        const GameConfig& config = options.config;
+        std::cout << "=== Laboratory Work #7: Asynchronous Programming ===\n";
+        std::cout << "Variant 4: Wandering Knight\n";
+        std::cout << "- Movement range: 30\n";
+        std::cout << "- Kill range: 10\n";
+        if (config.restorePath.empty()) {
+            std::cout << "- Map size: " << config.mapSize << "x" << config.mapSize << "\n";
+            std::cout << "- NPCs: " << config.npcCount << "\n";
+        } else {
+            std::cout << "- Restoring: " << config.restorePath << "\n";
+        }
+        std::cout << "- Duration: " << config.duration << " seconds\n";
+        std::cout << "- Threads: 3 (movement+combat detection, combat, map printing)\n\n";
+
+        Game game(config);
         game.run();
     } catch (const std::exception& e) {
         std::cerr << "Error: " << e.what() << std::endl;
         return 1;
     }
-    
+
     return 0;
 }
@@ -0,0 +1,118 @@
+#include "../include/map_renderer.h"
+#include <algorithm>
+#include <charconv>
+
+namespace {
+void appendNumber(std::string& out, uint64_t value) {
+    char buffer[24];
+    auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+    out.append(buffer, result.ptr);
+}
+}
+
+Viewport Viewport::centred(int mapSize, int width, int height) {
+    int startX = std::max(0, mapSize / 2 - width / 2);
+    int startY = std::max(0, mapSize / 2 - height / 2);
+    return {startX, startY,
+            std::min(mapSize, startX + width) - startX,
+            std::min(mapSize, startY + height) - startY};
+}
+
+char MapRenderer::symbol(NPC::Type type) {
+    return npcTraits(type).symbol;
+}
+
+void MapRenderer::renderViewport(const WorldSnapshot& snapshot, const Viewport& view, std::string& out) {
+    cells_.assign(static_cast<size_t>(view.width) * view.height, '.');
+
+    for (size_t i = 0; i < snapshot.alive(); ++i) {
+        int x, y;
+        World::unpack(snapshot.positions[i], x, y);
+        x -= view.x;
+        y -= view.y;
+        if (x < 0 || y < 0 || x >= view.width || y >= view.height) continue;
+
+        // If position already occupied, use '*' to indicate multiple NPCs
+        char& cell = cells_[static_cast<size_t>(y) * view.width + x];
+        cell = cell != '.' ? '*' : symbol(snapshot.types[i]);
+    }
+
+    out += "\n=== Map State ===\nCenter area (";
+    appendNumber(out, view.x);
+    out += '-';
+    appendNumber(out, view.x + view.width);
+    out += ", ";
+    appendNumber(out, view.y);
+    out += '-';
+    appendNumber(out, view.y + view.height);
+    out += "):\n";
+
+    for (int y = 0; y < view.height; ++y) {
+        for (int x = 0; x < view.width; ++x) {
+            out += cells_[static_cast<size_t>(y) * view.width + x];
+            out += ' ';
+        }
+        out += '\n';
+    }
+
+    out += "\nAlive NPCs: ";
+    appendNumber(out, snapshot.alive());
+    out += " / ";
+    appendNumber(out, snapshot.total);
+    out += "\nLegend: K=Knight, *=Multiple, .=Empty\n";
+}
+
+void MapRenderer::renderHeatmap(const WorldSnapshot& snapshot, int columns, int rows,
+                                HeatmapKind kind, std::string& out) {
+    columns = std::max(1, std::min(columns, snapshot.mapSize));
+    rows = std::max(1, std::min(rows, snapshot.mapSize));
+    size_t cellCount = static_cast<size_t>(columns) * rows;
+    counts_.assign(cellCount * NPC::kTypeCount, 0);
+
+    for (size_t i = 0; i < snapshot.alive(); ++i) {
+        int x, y;
+        World::unpack(snapshot.positions[i], x, y);
+        size_t cx = static_cast<size_t>(x) * columns / snapshot.mapSize;
+        size_t cy = static_cast<size_t>(y) * rows / snapshot.mapSize;
+        ++counts_[(cy * columns + cx) * NPC::kTypeCount + static_cast<size_t>(snapshot.types[i])];
+    }
+
+    uint32_t peak = 1;
+    for (size_t c = 0; c < cellCount; ++c) {
+        uint32_t total = 0;
+        for (size_t t = 0; t < NPC::kTypeCount; ++t) total += counts_[c * NPC::kTypeCount + t];
+        peak = std::max(peak, total);
+    }
+
+    static const char kRamp[] = " .:-=+*#%@";
+    constexpr size_t kRampLevels = sizeof(kRamp) - 2;
+
+    out += kind == HeatmapKind::Density ? "\n=== Density Heatmap " : "\n=== Type Heatmap ";
+    appendNumber(out, columns);
+    out += 'x';
+    appendNumber(out, rows);
+    out += " (peak ";
+    appendNumber(out, peak);
+    out += " per cell) ===\n";
+
+    for (int row = 0; row < rows; ++row) {
+        for (int column = 0; column < columns; ++column) {
+            const uint32_t* cell = &counts_[(static_cast<size_t>(row) * columns + column) * NPC::kTypeCount];
+            uint32_t total = 0;
+            size_t dominant = 0;
+            for (size_t t = 0; t < NPC::kTypeCount; ++t) {
+                total += cell[t];
+                if (cell[t] > cell[dominant]) dominant = t;
+            }
+
+            if (kind == HeatmapKind::Density) {
+                size_t level = total == 0 ? 0 : 1 + (static_cast<size_t>(total) * (kRampLevels - 1)) / peak;
+                out += kRamp[std::min(level, kRampLevels)];
+            } else {
+                out += total == 0 ? '.' : symbol(static_cast<NPC::Type>(dominant));
+            }
+        }
+        out += '\n';
+    }
+}
+
@@ -1,40 +1,49 @@
 #include "../include/npc.h"
+#include "../include/world.h"
+#include "../include/philox.h"
 #include <cmath>
 
-thread_local std::mt19937 NPC::rng_(std::random_device{}());
+NPC::NPC(World& world, uint32_t index)
+    : world_(&world), index_(index) {}
 
-NPC::NPC(Type type, const std::string& name, int x, int y)
-    : type_(type), name_(name), x_(x), y_(y), alive_(true) {}
+NPC::Type NPC::getType() const {
+    return world_->type(index_);
+}
+
+std::string_view NPC::getName() const {
+    return world_->name(index_);
+}
 
 int NPC::getX() const {
-    std::lock_guard<std::mutex> lock(posMutex_);
-    return x_;
+    int x, y;
+    world_->getPosition(index_, x, y);
+    return x;
 }
 
 int NPC::getY() const {
-    std::lock_guard<std::mutex> lock(posMutex_);
-    return y_;
+    int x, y;
+    world_->getPosition(index_, x, y);
+    return y;
 }
 
 void NPC::getPosition(int& x, int& y) const {
-    std::lock_guard<std::mutex> lock(posMutex_);
-    x = x_;
-    y = y_;
+    world_->getPosition(index_, x, y);
+}
+
+bool NPC::isAlive() const {
+    return world_->isAlive(index_);
 }
 
 void NPC::setPosition(int x, int y) {
-    std::lock_guard<std::mutex> lock(posMutex_);
-    x_ = x;
-    y_ = y;
+    world_->setPosition(index_, x, y);
 }
 
 void NPC::kill() {
-    alive_ = false;
+    world_->kill(index_);
 }
 
-int NPC::rollDice() const {
-    static thread_local std::uniform_int_distribution<int> dist(1, 6);
-    return dist(rng_);
+int NPC::rollDice(uint64_t seed, uint64_t draw) const {
+    return 1 + static_cast<int>(uniformBelow(randomWords(seed, draw, index_, RngPurpose::Dice)[0], 6));
 }
 
 double NPC::distanceTo(const NPC& other) const {
@@ -47,21 +56,17 @@ double NPC::distanceTo(const NPC& other) const {
     return std::sqrt(dx * dx + dy * dy);
 }
 
-int NPC::distanceSquaredTo(const NPC& other) const {
+long long NPC::distanceSquaredTo(const NPC& other) const {
     int x1, y1, x2, y2;
     getPosition(x1, y1);
     other.getPosition(x2, y2);
     
-    int dx = x1 - x2;
-    int dy = y1 - y2;
+    // 64-bit so far-apart NPCs on large maps don't overflow
+    long long dx = x1 - x2;
+    long long dy = y1 - y2;
     return dx * dx + dy * dy;
 }
 
-std::string NPC::typeToString(Type type) {
-    switch (type) {
-        case Type::Knight: return "Knight";
-        case Type::Squirrel: return "Squirrel";
-        case Type::Pegasus: return "Pegasus";
-        default: return "Unknown";
-    }
+std::string_view NPC::typeToString(Type type) {
+    return static_cast<size_t>(type) < kTypeCount ? npcTraits(type).name : "Unknown";
 }
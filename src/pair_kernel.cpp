@@ -0,0 +1,208 @@
+#include "../include/pair_kernel.h"
+#include <algorithm>
+#include <atomic>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define LAB7_X86 1
+#include <immintrin.h>
+#endif
+
+namespace {
+
+using MaskFn = uint64_t (*)(int, int, int, const int*, const int*, const int*, size_t);
+
+// Beyond this |dx| or |dy| no pair can be in range, and 2 * 32767^2 still
+// fits in an unsigned 32-bit lane
+constexpr int kMaxDelta = 32767;
+
+uint64_t maskScalar(int x, int y, int range,
+                    const int* xs, const int* ys, const int* ranges, size_t count) {
+    uint64_t mask = 0;
+    for (size_t k = 0; k < count; ++k) {
+        long long dx = static_cast<long long>(xs[k]) - x;
+        long long dy = static_cast<long long>(ys[k]) - y;
+        long long r = std::max(range, ranges[k]);
+        if (dx * dx + dy * dy <= r * r) mask |= uint64_t{1} << k;
+    }
+    return mask;
+}
+
+#ifdef LAB7_X86
+
+// The SSE and AVX2 variants run the last partial group through a
+// zero-filled copy instead of reading past the caller's arrays
+template <size_t Width>
+struct Tail {
+    int xs[Width] = {};
+    int ys[Width] = {};
+    int ranges[Width] = {};
+
+    Tail(const int* x, const int* y, const int* r, size_t count) {
+        std::copy(x, x + count, xs);
+        std::copy(y, y + count, ys);
+        std::copy(r, r + count, ranges);
+    }
+};
+
+__attribute__((target("sse4.1")))
+uint32_t groupSse41(__m128i x, __m128i y, __m128i range, const int* xs, const int* ys, const int* ranges) {
+    const __m128i limit = _mm_set1_epi32(kMaxDelta);
+    __m128i dx = _mm_min_epu32(_mm_abs_epi32(_mm_sub_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(xs)), x)), limit);
+    __m128i dy = _mm_min_epu32(_mm_abs_epi32(_mm_sub_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(ys)), y)), limit);
+    __m128i d2 = _mm_add_epi32(_mm_mullo_epi32(dx, dx), _mm_mullo_epi32(dy, dy));
+    __m128i r = _mm_max_epi32(range, _mm_loadu_si128(reinterpret_cast<const __m128i*>(ranges)));
+    __m128i r2 = _mm_mullo_epi32(r, r);
+    // Unsigned d2 <= r2
+    __m128i hit = _mm_cmpeq_epi32(_mm_max_epu32(d2, r2), r2);
+    return static_cast<uint32_t>(_mm_movemask_ps(_mm_castsi128_ps(hit)));
+}
+
+__attribute__((target("sse4.1")))
+uint64_t maskSse41(int x, int y, int range,
+                   const int* xs, const int* ys, const int* ranges, size_t count) {
+    __m128i vx = _mm_set1_epi32(x);
+    __m128i vy = _mm_set1_epi32(y);
+    __m128i vr = _mm_set1_epi32(range);
+    
+    uint64_t mask = 0;
+    size_t k = 0;
+    for (; k + 4 <= count; k += 4) {
+        mask |= uint64_t{groupSse41(vx, vy, vr, xs + k, ys + k, ranges + k)} << k;
+    }
+    if (k < count) {
+        Tail<4> tail(xs + k, ys + k, ranges + k, count - k);
+        uint64_t bits = groupSse41(vx, vy, vr, tail.xs, tail.ys, tail.ranges);
+        mask |= (bits & ((uint64_t{1} << (count - k)) - 1)) << k;
+    }
+    return mask;
+}
+
+__attribute__((target("avx2")))
+uint32_t groupAvx2(__m256i x, __m256i y, __m256i range, const int* xs, const int* ys, const int* ranges) {
+    const __m256i limit = _mm256_set1_epi32(kMaxDelta);
+    __m256i dx = _mm256_min_epu32(_mm256_abs_epi32(_mm256_sub_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(xs)), x)), limit);
+    __m256i dy = _mm256_min_epu32(_mm256_abs_epi32(_mm256_sub_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(ys)), y)), limit);
+    __m256i d2 = _mm256_add_epi32(_mm256_mullo_epi32(dx, dx), _mm256_mullo_epi32(dy, dy));
+    __m256i r = _mm256_max_epi32(range, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(ranges)));
+    __m256i r2 = _mm256_mullo_epi32(r, r);
+    __m256i hit = _mm256_cmpeq_epi32(_mm256_max_epu32(d2, r2), r2);
+    return static_cast<uint32_t>(_mm256_movemask_ps(_mm256_castsi256_ps(hit)));
+}
+
+__attribute__((target("avx2")))
+uint64_t maskAvx2(int x, int y, int range,
+                  const int* xs, const int* ys, const int* ranges, size_t count) {
+    __m256i vx = _mm256_set1_epi32(x);
+    __m256i vy = _mm256_set1_epi32(y);
+    __m256i vr = _mm256_set1_epi32(range);
+    
+    uint64_t mask = 0;
+    size_t k = 0;
+    for (; k + 8 <= count; k += 8) {
+        mask |= uint64_t{groupAvx2(vx, vy, vr, xs + k, ys + k, ranges + k)} << k;
+    }
+    if (k < count) {
+        Tail<8> tail(xs + k, ys + k, ranges + k, count - k);
+        uint64_t bits = groupAvx2(vx, vy, vr, tail.xs, tail.ys, tail.ranges);
+        mask |= (bits & ((uint64_t{1} << (count - k)) - 1)) << k;
+    }
+    return mask;
+}
+
+__attribute__((target("avx512f")))
+uint64_t maskAvx512(int x, int y, int range,
+                    const int* xs, const int* ys, const int* ranges, size_t count) {
+    const __m512i limit = _mm512_set1_epi32(kMaxDelta);
+    __m512i vx = _mm512_set1_epi32(x);
+    __m512i vy = _mm512_set1_epi32(y);
+    __m512i vr = _mm512_set1_epi32(range);
+    
+    uint64_t mask = 0;
+    for (size_t k = 0; k < count; k += 16) {
+        // Masked loads handle the tail without touching memory past count
+        size_t lanes = std::min<size_t>(16, count - k);
+        __mmask16 live = static_cast<__mmask16>((1u << lanes) - 1);
+        __m512i cx = _mm512_maskz_loadu_epi32(live, xs + k);
+        __m512i cy = _mm512_maskz_loadu_epi32(live, ys + k);
+        __m512i cr = _mm512_maskz_loadu_epi32(live, ranges + k);
+        
+        // maskz forms: GCC 12 warns about the undefined source of the plain ones
+        __m512i dx = _mm512_maskz_min_epu32(live, _mm512_maskz_abs_epi32(live, _mm512_sub_epi32(cx, vx)), limit);
+        __m512i dy = _mm512_maskz_min_epu32(live, _mm512_maskz_abs_epi32(live, _mm512_sub_epi32(cy, vy)), limit);
+        __m512i d2 = _mm512_add_epi32(_mm512_mullo_epi32(dx, dx), _mm512_mullo_epi32(dy, dy));
+        __m512i r = _mm512_maskz_max_epi32(live, vr, cr);
+        __m512i r2 = _mm512_mullo_epi32(r, r);
+        __mmask16 hit = _mm512_mask_cmple_epu32_mask(live, d2, r2);
+        mask |= uint64_t{hit} << k;
+    }
+    return mask;
+}
+
+#endif
+
+bool supported(PairKernel kernel) {
+#ifdef LAB7_X86
+    // May run from a static initializer, before the CPU model is set up
+    __builtin_cpu_init();
+    switch (kernel) {
+        case PairKernel::Scalar: return true;
+        case PairKernel::Sse41: return __builtin_cpu_supports("sse4.1");
+        case PairKernel::Avx2: return __builtin_cpu_supports("avx2");
+        case PairKernel::Avx512: return __builtin_cpu_supports("avx512f");
+    }
+    return false;
+#else
+    return kernel == PairKernel::Scalar;
+#endif
+}
+
+MaskFn functionFor(PairKernel kernel) {
+#ifdef LAB7_X86
+    switch (kernel) {
+        case PairKernel::Scalar: return maskScalar;
+        case PairKernel::Sse41: return maskSse41;
+        case PairKernel::Avx2: return maskAvx2;
+        case PairKernel::Avx512: return maskAvx512;
+    }
+#endif
+    return maskScalar;
+}
+
+PairKernel bestKernel() {
+    for (PairKernel kernel : {PairKernel::Avx512, PairKernel::Avx2, PairKernel::Sse41}) {
+        if (supported(kernel)) return kernel;
+    }
+    return PairKernel::Scalar;
+}
+
+// Relaxed loads compile to plain loads; the pair is only changed between runs
+std::atomic<PairKernel> activeKernel{bestKernel()};
+std::atomic<MaskFn> activeMask{functionFor(activeKernel.load())};
+
+} // namespace
+
+uint64_t rangeMask(int x, int y, int range,
+                   const int* xs, const int* ys, const int* ranges, size_t count) {
+    return activeMask.load(std::memory_order_relaxed)(x, y, range, xs, ys, ranges, count);
+}
+
+PairKernel activePairKernel() {
+    return activeKernel.load(std::memory_order_relaxed);
+}
+
+bool selectPairKernel(PairKernel kernel) {
+    if (!supported(kernel)) return false;
+    activeKernel.store(kernel, std::memory_order_relaxed);
+    activeMask.store(functionFor(kernel), std::memory_order_relaxed);
+    return true;
+}
+
+const char* pairKernelName(PairKernel kernel) {
+    switch (kernel) {
+        case PairKernel::Scalar: return "scalar";
+        case PairKernel::Sse41: return "sse4.1";
+        case PairKernel::Avx2: return "avx2";
+        case PairKernel::Avx512: return "avx512";
+    }
+    return "unknown";
+}
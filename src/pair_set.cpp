@@ -0,0 +1,76 @@
+#include "../include/pair_set.h"
+#include <algorithm>
+
+bool PairSet::insert(uint64_t key, uint64_t value) {
+    // Keep the load factor at or below one half
+    if ((size_ + 1) * 2 > keys_.size()) grow();
+
+    size_t slot = slotOf(key);
+    if (keys_[slot] == key) return false;
+
+    keys_[slot] = key;
+    values_[slot] = value;
+    ++size_;
+    return true;
+}
+
+bool PairSet::erase(uint64_t key) {
+    if (size_ == 0) return false;
+
+    size_t hole = slotOf(key);
+    if (keys_[hole] != key) return false;
+
+    // Backward-shift deletion: later entries of the probe run move into the
+    // hole when it lies between their home slot and where they sit, so a
+    // lookup never stops early at an empty slot
+    size_t mask = keys_.size() - 1;
+    for (size_t next = (hole + 1) & mask; keys_[next] != kEmpty; next = (next + 1) & mask) {
+        if (((next - homeOf(keys_[next])) & mask) >= ((next - hole) & mask)) {
+            keys_[hole] = keys_[next];
+            values_[hole] = values_[next];
+            hole = next;
+        }
+    }
+    keys_[hole] = kEmpty;
+    --size_;
+    return true;
+}
+
+const uint64_t* PairSet::find(uint64_t key) const {
+    if (size_ == 0) return nullptr;
+
+    size_t slot = slotOf(key);
+    return keys_[slot] == key ? &values_[slot] : nullptr;
+}
+
+void PairSet::clear() {
+    if (size_ == 0) return;
+    std::fill(keys_.begin(), keys_.end(), kEmpty);
+    size_ = 0;
+}
+
+void PairSet::grow() {
+    std::vector<uint64_t> keys(std::max<size_t>(64, keys_.size() * 2), kEmpty);
+    std::vector<uint64_t> values(keys.size());
+    keys.swap(keys_);
+    values.swap(values_);
+
+    size_ = 0;
+    for (size_t i = 0; i < keys.size(); ++i) {
+        if (keys[i] != kEmpty) insert(keys[i], values[i]);
+    }
+}
+
+size_t PairSet::homeOf(uint64_t key) const {
+    // Fibonacci hashing spreads the packed indices over the table
+    return static_cast<size_t>((key * 0x9E3779B97F4A7C15ull) >> 20) & (keys_.size() - 1);
+}
+
+size_t PairSet::slotOf(uint64_t key) const {
+    size_t mask = keys_.size() - 1;
+    size_t slot = homeOf(key);
+    while (keys_[slot] != kEmpty && keys_[slot] != key) {
+        slot = (slot + 1) & mask;
+    }
+    return slot;
+}
@@ -1,4 +0,0 @@
-#include "../include/pegasus.h"
-
-Pegasus::Pegasus(const std::string& name, int x, int y)
-    : NPC(Type::Pegasus, name, x, y) {}
@@ -0,0 +1,223 @@
+#include "../include/profiler.h"
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <stdexcept>
+
+namespace {
+// Small, stable per-thread ids for the trace
+std::atomic<uint32_t> nextThreadId{1};
+
+uint32_t threadId() {
+    thread_local uint32_t id = nextThreadId.fetch_add(1, std::memory_order_relaxed);
+    return id;
+}
+
+// Eight linear sub-buckets per power of two: under 13% error at any scale
+constexpr size_t kSubBuckets = 8;
+
+size_t bucketOf(uint64_t value) {
+    if (value < kSubBuckets) return static_cast<size_t>(value);
+    size_t octave = 63 - static_cast<size_t>(__builtin_clzll(value));
+    size_t sub = static_cast<size_t>(value >> (octave - 3)) & (kSubBuckets - 1);
+    return std::min(Histogram::kBuckets - 1, (octave - 2) * kSubBuckets + sub);
+}
+
+uint64_t bucketUpper(size_t bucket) {
+    if (bucket < kSubBuckets) return bucket;
+    size_t octave = bucket / kSubBuckets + 2;
+    uint64_t sub = bucket % kSubBuckets;
+    return ((kSubBuckets + sub + 1) << (octave - 3)) - 1;
+}
+
+double micros(uint64_t ns) {
+    return static_cast<double>(ns) / 1000.0;
+}
+
+void dumpRow(std::ostream& out, const char* name, const Histogram& h, bool time) {
+    out << "  " << std::left << std::setw(16) << name << std::right
+        << std::setw(10) << h.count();
+    if (time) {
+        out << std::setw(12) << micros(static_cast<uint64_t>(h.mean()))
+            << std::setw(12) << micros(h.percentile(0.5))
+            << std::setw(12) << micros(h.percentile(0.99))
+            << std::setw(12) << micros(h.max()) << "\n";
+    } else {
+        out << std::setw(12) << h.mean()
+            << std::setw(12) << h.percentile(0.5)
+            << std::setw(12) << h.percentile(0.99)
+            << std::setw(12) << h.max() << "\n";
+    }
+}
+}
+
+void Histogram::record(uint64_t value) {
+    buckets_[bucketOf(value)].fetch_add(1, std::memory_order_relaxed);
+    count_.fetch_add(1, std::memory_order_relaxed);
+    sum_.fetch_add(value, std::memory_order_relaxed);
+    uint64_t seen = max_.load(std::memory_order_relaxed);
+    while (value > seen && !max_.compare_exchange_weak(seen, value, std::memory_order_relaxed)) {}
+}
+
+void Histogram::reset() {
+    for (auto& bucket : buckets_) bucket.store(0, std::memory_order_relaxed);
+    count_.store(0, std::memory_order_relaxed);
+    sum_.store(0, std::memory_order_relaxed);
+    max_.store(0, std::memory_order_relaxed);
+}
+
+double Histogram::mean() const {
+    uint64_t n = count();
+    return n ? static_cast<double>(sum_.load(std::memory_order_relaxed)) / n : 0.0;
+}
+
+uint64_t Histogram::percentile(double q) const {
+    uint64_t n = count();
+    if (n == 0) return 0;
+
+    uint64_t rank = static_cast<uint64_t>(q * static_cast<double>(n - 1)) + 1;
+    uint64_t seen = 0;
+    for (size_t b = 0; b < kBuckets; ++b) {
+        seen += buckets_[b].load(std::memory_order_relaxed);
+        if (seen >= rank) return std::min(max(), bucketUpper(b));
+    }
+    return max();
+}
+
+void Profiler::start(uint64_t traceStart, uint64_t traceTicks) {
+    if (!kProfilingBuilt) {
+        throw std::invalid_argument("profiling requested but built without LAB7_PROFILING");
+    }
+    reset();
+    enabled_ = true;
+    startNs_ = now();
+
+    traceStart_ = traceStart;
+    traceEnd_ = traceStart + traceTicks;
+    if (traceTicks > 0 && !traceEvents_) {
+        traceEvents_ = std::make_unique<TraceEvent[]>(kTraceCapacity);
+    }
+}
+
+void Profiler::reset() {
+    ticks_.store(0, std::memory_order_relaxed);
+    for (auto& h : phases_) h.reset();
+    for (auto& h : lockWait_) h.reset();
+    for (auto& h : lockHold_) h.reset();
+    queueDepth_.reset();
+    tracing_.store(false, std::memory_order_relaxed);
+    traceCount_.store(0, std::memory_order_relaxed);
+}
+
+void Profiler::beginTick(uint64_t tick) {
+    if (!enabled()) return;
+    ticks_.fetch_add(1, std::memory_order_relaxed);
+    bool inWindow = traceEvents_ && tick >= traceStart_ && tick < traceEnd_;
+    tracing_.store(inWindow, std::memory_order_relaxed);
+}
+
+void Profiler::recordPhase(Phase phase, uint64_t startNs, uint64_t endNs) {
+    if (!enabled()) return;
+    phases_[static_cast<size_t>(phase)].record(endNs - startNs);
+    trace(phaseName(phase), startNs, endNs - startNs, false);
+}
+
+void Profiler::recordLockWait(LockSite site, uint64_t startNs, uint64_t endNs) {
+    if (!enabled()) return;
+    lockWait_[static_cast<size_t>(site)].record(endNs - startNs);
+    // Uncontended acquisitions would only clutter the trace
+    if (endNs - startNs >= 1000) trace(lockName(site), startNs, endNs - startNs, false);
+}
+
+void Profiler::recordLockHold(LockSite site, uint64_t ns) {
+    if (!enabled()) return;
+    lockHold_[static_cast<size_t>(site)].record(ns);
+}
+
+void Profiler::recordQueueDepth(size_t depth) {
+    if (!enabled()) return;
+    queueDepth_.record(depth);
+    trace("combat queue depth", now(), depth, true);
+}
+
+void Profiler::trace(const char* name, uint64_t startNs, uint64_t value, bool counter) {
+    if (!tracing_.load(std::memory_order_relaxed)) return;
+    size_t slot = traceCount_.fetch_add(1, std::memory_order_relaxed);
+    if (slot >= kTraceCapacity) return;
+    traceEvents_[slot] = {name, startNs, value, threadId(), counter};
+}
+
+void Profiler::dump(std::ostream& out) const {
+    if (!enabled()) return;
+
+    std::ios::fmtflags flags = out.flags();
+    out << std::fixed << std::setprecision(1)
+        << "\n=== Profile: " << ticks_.load(std::memory_order_relaxed) << " ticks in "
+        << micros(now() - startNs_) / 1e6 << " s ===\n"
+        << "  " << std::left << std::setw(16) << "phase (us)" << std::right << std::setw(10) << "count"
+        << std::setw(12) << "mean" << std::setw(12) << "p50"
+        << std::setw(12) << "p99" << std::setw(12) << "max" << "\n";
+    for (size_t p = 0; p < phases_.size(); ++p) {
+        if (phases_[p].count() == 0) continue;
+        dumpRow(out, phaseName(static_cast<Phase>(p)), phases_[p], true);
+    }
+
+    for (size_t l = 0; l < lockWait_.size(); ++l) {
+        std::string name = lockName(static_cast<LockSite>(l));
+        dumpRow(out, (name + " wait").c_str(), lockWait_[l], true);
+        dumpRow(out, (name + " hold").c_str(), lockHold_[l], true);
+    }
+
+    if (queueDepth_.count() > 0) dumpRow(out, "queue depth", queueDepth_, false);
+
+    size_t traced = traceCount_.load(std::memory_order_relaxed);
+    if (traced > kTraceCapacity) {
+        out << "  trace buffer full, " << traced - kTraceCapacity << " events dropped\n";
+    }
+    out.flags(flags);
+}
+
+void Profiler::writeTrace(const std::string& path) const {
+    if (!enabled() || !traceEvents_) return;
+
+    std::ofstream file(path);
+    if (!file) throw std::runtime_error("cannot open trace file '" + path + "'");
+
+    // Chrome trace-event format; timestamps in microseconds
+    file << std::fixed << std::setprecision(3) << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [";
+    size_t count = std::min(traceCount_.load(std::memory_order_relaxed), kTraceCapacity);
+    for (size_t i = 0; i < count; ++i) {
+        const TraceEvent& event = traceEvents_[i];
+        file << (i ? ",\n" : "\n") << "{\"name\": \"" << event.name << "\", \"pid\": 1, \"tid\": "
+             << event.thread << ", \"ts\": " << micros(event.startNs - startNs_);
+        if (event.counter) {
+            file << ", \"ph\": \"C\", \"args\": {\"depth\": " << event.value << "}}";
+        } else {
+            file << ", \"ph\": \"X\", \"dur\": " << micros(event.value) << "}";
+        }
+    }
+    file << "\n]}\n";
+}
+
+const char* Profiler::phaseName(Phase phase) {
+    switch (phase) {
+        case Phase::Tick: return "tick";
+        case Phase::Move: return "move";
+        case Phase::Detect: return "detect";
+        case Phase::Publish: return "publish";
+        case Phase::QueueStall: return "queue stall";
+        case Phase::Resolve: return "resolve";
+        case Phase::CombatIdle: return "combat idle";
+        case Phase::Snapshot: return "snapshot";
+        case Phase::Render: return "render";
+        default: return "unknown";
+    }
+}
+
+const char* Profiler::lockName(LockSite site) {
+    switch (site) {
+        case LockSite::Npcs: return "npcsMutex";
+        case LockSite::Cout: return "coutMutex";
+        default: return "unknown";
+    }
+}
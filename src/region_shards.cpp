@@ -0,0 +1,169 @@
+#include "../include/region_shards.h"
+#include <algorithm>
+
+namespace {
+// Strips are sized so each holds many grid cells; more shards than this
+// only adds per-shard overhead
+constexpr int kCellsPerStrip = 8;
+}
+
+void RegionShards::configure(int mapSize, int halo) {
+    mapSize_ = std::max(1, mapSize);
+    halo_ = std::max(1, halo);
+
+    size_t count = static_cast<size_t>(std::max(1, mapSize_ / (kCellsPerStrip * halo_)));
+    count = std::min(count, kMaxShards);
+    stripHeight_ = (mapSize_ + static_cast<int>(count) - 1) / static_cast<int>(count);
+
+    shards_.resize(count);
+    assigned_ = false;
+}
+
+size_t RegionShards::shardOf(int y) const {
+    return std::min(static_cast<size_t>(std::max(0, y) / stripHeight_), shards_.size() - 1);
+}
+
+void RegionShards::findPairs(const World& world, ThreadPool& pool, std::vector<Pair>& out) {
+    if (shards_.empty()) configure(mapSize_, halo_);
+    if (!assigned_) assign(world);
+
+    size_t count = shards_.size();
+    pool.parallelFor(0, count, 1, [&](size_t begin, size_t end, unsigned) {
+        for (size_t s = begin; s < end; ++s) migrate(world, s);
+    });
+    pool.parallelFor(0, count, 1, [&](size_t begin, size_t end, unsigned) {
+        for (size_t s = begin; s < end; ++s) adopt(world, s);
+    });
+    pool.parallelFor(0, count, 1, [&](size_t begin, size_t end, unsigned) {
+        for (size_t s = begin; s < end; ++s) detect(s);
+    });
+
+    for (const auto& shard : shards_) {
+        migrations_ += shard.up.size() + shard.down.size() + shard.far.size();
+        out.insert(out.end(), shard.pairs.begin(), shard.pairs.end());
+    }
+}
+
+void RegionShards::assign(const World& world) {
+    for (auto& shard : shards_) {
+        shard.members.clear();
+        shard.up.clear();
+        shard.down.clear();
+        shard.far.clear();
+    }
+    for (World::Index i : world.active()) {
+        if (!world.isAlive(i)) continue;
+        int x, y;
+        world.getPosition(i, x, y);
+        shards_[shardOf(y)].members.push_back(i);
+    }
+    assigned_ = true;
+}
+
+void RegionShards::migrate(const World& world, size_t s) {
+    Shard& shard = shards_[s];
+    shard.up.clear();
+    shard.down.clear();
+    shard.far.clear();
+
+    size_t kept = 0;
+    for (World::Index npc : shard.members) {
+        if (!world.isAlive(npc)) continue;
+
+        int x, y;
+        world.getPosition(npc, x, y);
+        size_t target = shardOf(y);
+        if (target == s) {
+            shard.members[kept++] = npc;
+        } else if (target == s + 1) {
+            shard.up.push_back(npc);
+        } else if (target + 1 == s) {
+            shard.down.push_back(npc);
+        } else {
+            shard.far.push_back(npc);
+        }
+    }
+    shard.members.resize(kept);
+}
+
+void RegionShards::adopt(const World& world, size_t s) {
+    Shard& shard = shards_[s];
+
+    // Fixed order (below, above, then far lists by source) keeps member
+    // order, and so pair order, independent of scheduling
+    if (s > 0) {
+        const auto& from = shards_[s - 1].up;
+        shard.members.insert(shard.members.end(), from.begin(), from.end());
+    }
+    if (s + 1 < shards_.size()) {
+        const auto& from = shards_[s + 1].down;
+        shard.members.insert(shard.members.end(), from.begin(), from.end());
+    }
+    for (const auto& source : shards_) {
+        for (World::Index npc : source.far) {
+            int x, y;
+            world.getPosition(npc, x, y);
+            if (shardOf(y) == s) shard.members.push_back(npc);
+        }
+    }
+
+    size_t count = shard.members.size();
+    shard.xs.resize(count);
+    shard.ys.resize(count);
+    shard.ranges.resize(count);
+    shard.indices.resize(count);
+    shard.haloX.clear();
+    shard.haloY.clear();
+    shard.haloRange.clear();
+    shard.haloIndex.clear();
+
+    int haloEnd = static_cast<int>(s) * stripHeight_ + halo_;
+    for (size_t k = 0; k < count; ++k) {
+        World::Index npc = shard.members[k];
+        world.getPosition(npc, shard.xs[k], shard.ys[k]);
+        shard.ranges[k] = world.killRange(npc);
+        shard.indices[k] = npc;
+
+        if (s > 0 && shard.ys[k] < haloEnd) {
+            shard.haloX.push_back(shard.xs[k]);
+            shard.haloY.push_back(shard.ys[k]);
+            shard.haloRange.push_back(shard.ranges[k]);
+            shard.haloIndex.push_back(npc);
+        }
+    }
+}
+
+void RegionShards::detect(size_t s) {
+    Shard& shard = shards_[s];
+    size_t members = shard.members.size();
+
+    // Halo exchange: the bottom strip of the shard above joins as
+    // neighbours only, after the members
+    shard.xs.resize(members);
+    shard.ys.resize(members);
+    shard.ranges.resize(members);
+    shard.indices.resize(members);
+    if (s + 1 < shards_.size()) {
+        const Shard& above = shards_[s + 1];
+        shard.xs.insert(shard.xs.end(), above.haloX.begin(), above.haloX.end());
+        shard.ys.insert(shard.ys.end(), above.haloY.begin(), above.haloY.end());
+        shard.ranges.insert(shard.ranges.end(), above.haloRange.begin(), above.haloRange.end());
+        shard.indices.insert(shard.indices.end(), above.haloIndex.begin(), above.haloIndex.end());
+    }
+
+    shard.pairs.clear();
+    shard.grid.rebuild(shard.xs.data(), shard.ys.data(), shard.ranges.data(),
+                       shard.xs.size(), halo_);
+    // Only member-side points; halo points are neighbours, never owners
+    shard.grid.findPairs(shard.xs.data(), shard.ys.data(), shard.ranges.data(),
+                         0, members, shard.pairs);
+
+    for (auto& pair : shard.pairs) {
+        World::Index a = shard.indices[pair.first];
+        World::Index b = shard.indices[pair.second];
+        pair = {std::min(a, b), std::max(a, b)};
+    }
+    // Member order depends on migration history; sorting makes the output a
+    // function of positions alone, so a restored checkpoint resumes exactly
+    std::sort(shard.pairs.begin(), shard.pairs.end());
+}
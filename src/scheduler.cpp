@@ -0,0 +1,84 @@
+#include "../include/scheduler.h"
+#include <algorithm>
+
+Scheduler::Scheduler(Clock::duration resolution)
+    : resolution_(std::max(resolution, Clock::duration(1))) {}
+
+void Scheduler::every(Clock::duration period, std::function<void()> task) {
+    auto slots = static_cast<uint64_t>((period + resolution_ - Clock::duration(1)) / resolution_);
+    tasks_.push_back({std::max<uint64_t>(1, slots), 0, std::move(task)});
+}
+
+void Scheduler::reset() {
+    tasks_.clear();
+    for (auto& slot : wheel_) slot.clear();
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopping_ = false;
+}
+
+void Scheduler::insert(size_t task) {
+    wheel_[tasks_[task].due % kSlots].push_back(task);
+}
+
+uint64_t Scheduler::nextDue(uint64_t from) const {
+    // Tasks in a slot may be due on a later turn of the wheel, so a slot
+    // only counts if one of its tasks is due on this turn
+    for (uint64_t turn = from;; turn += kSlots) {
+        for (uint64_t slot = turn; slot < turn + kSlots; ++slot) {
+            for (size_t task : wheel_[slot % kSlots]) {
+                if (tasks_[task].due == slot) return slot;
+            }
+        }
+    }
+}
+
+void Scheduler::run() {
+    if (tasks_.empty()) return;
+
+    for (auto& slot : wheel_) slot.clear();
+    for (size_t t = 0; t < tasks_.size(); ++t) {
+        tasks_[t].due = tasks_[t].period;
+        insert(t);
+    }
+
+    const Clock::time_point start = Clock::now();
+    uint64_t current = 0;
+    while (true) {
+        current = nextDue(current);
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            if (wakeCV_.wait_until(lock, start + resolution_ * current, [this] { return stopping_; })) {
+                return;
+            }
+        }
+
+        // Take the due tasks out of the slot before running them, since a
+        // task with a period of a whole turn goes straight back into it
+        auto& slot = wheel_[current % kSlots];
+        due_.clear();
+        auto kept = std::partition(slot.begin(), slot.end(),
+                                   [&](size_t task) { return tasks_[task].due != current; });
+        due_.assign(kept, slot.end());
+        slot.erase(kept, slot.end());
+        // partition keeps no order; run them in the order they were added
+        std::sort(due_.begin(), due_.end());
+
+        for (size_t task : due_) tasks_[task].run();
+
+        // Late tasks skip the runs they missed
+        auto elapsed = static_cast<uint64_t>((Clock::now() - start) / resolution_);
+        for (size_t task : due_) {
+            Task& t = tasks_[task];
+            t.due = std::max(current + t.period, elapsed + 1);
+            insert(task);
+        }
+    }
+}
+
+void Scheduler::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    wakeCV_.notify_all();
+}
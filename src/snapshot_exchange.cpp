@@ -0,0 +1,71 @@
+#include "../include/snapshot_exchange.h"
+#include <utility>
+
+SnapshotExchange::SnapshotExchange() {
+    for (; slotCount_ < kInitialSlots; ++slotCount_) {
+        slots_[slotCount_] = std::make_unique<Slot>();
+    }
+}
+
+SnapshotExchange::Reader::Reader(Reader&& other) noexcept
+    : exchange_(std::exchange(other.exchange_, nullptr)), slot_(other.slot_) {}
+
+SnapshotExchange::Reader& SnapshotExchange::Reader::operator=(Reader&& other) noexcept {
+    if (this != &other) {
+        release();
+        exchange_ = std::exchange(other.exchange_, nullptr);
+        slot_ = other.slot_;
+    }
+    return *this;
+}
+
+SnapshotExchange::Reader::~Reader() {
+    release();
+}
+
+void SnapshotExchange::Reader::release() {
+    if (exchange_ == nullptr) return;
+    exchange_->slots_[slot_]->readers.fetch_sub(1, std::memory_order_release);
+    exchange_ = nullptr;
+}
+
+SnapshotExchange::Reader SnapshotExchange::acquire() const {
+    while (true) {
+        size_t slot = current_.load(std::memory_order_seq_cst);
+        if (slot == kNone) return Reader();
+        
+        // Pin, then confirm the writer did not move on (and possibly start
+        // refilling this slot) before the pin became visible
+        slots_[slot]->readers.fetch_add(1, std::memory_order_seq_cst);
+        if (current_.load(std::memory_order_seq_cst) == slot) {
+            return Reader(this, slot);
+        }
+        slots_[slot]->readers.fetch_sub(1, std::memory_order_release);
+    }
+}
+
+bool SnapshotExchange::publish(const World& world, uint64_t tick, int mapSize) {
+    size_t slot = claimSlot();
+    if (slot == kNone) {
+        skipped_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    slots_[slot]->snapshot.capture(world, tick, mapSize);
+    current_.store(slot, std::memory_order_seq_cst);
+    published_.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+size_t SnapshotExchange::claimSlot() {
+    size_t current = current_.load(std::memory_order_relaxed);
+    for (size_t i = 1; i <= slotCount_; ++i) {
+        size_t slot = (current + i) % slotCount_;
+        if (slot == current) continue;
+        if (slots_[slot]->readers.load(std::memory_order_seq_cst) == 0) return slot;
+    }
+    
+    // Every spare slot is pinned: grow rather than wait for a reader
+    if (slotCount_ == kMaxSlots) return kNone;
+    slots_[slotCount_] = std::make_unique<Slot>();
+    return slotCount_++;
+}
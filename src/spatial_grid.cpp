@@ -0,0 +1,82 @@
+#include "../include/spatial_grid.h"
+#include "../include/pair_kernel.h"
+#include <algorithm>
+
+void SpatialGrid::rebuild(const int* xs, const int* ys, const int* ranges, size_t count, int cellSize) {
+    cellSize_ = std::max(1, cellSize);
+
+    size_t buckets = 1;
+    while (buckets < count) buckets <<= 1;
+    mask_ = buckets - 1;
+
+    cellX_.resize(count);
+    cellY_.resize(count);
+    bucketStart_.assign(buckets + 1, 0);
+    sorted_.resize(count);
+    sortedX_.resize(count);
+    sortedY_.resize(count);
+    sortedRange_.resize(count);
+
+    // Counting sort by bucket: count, prefix sum, scatter
+    for (size_t i = 0; i < count; ++i) {
+        cellX_[i] = xs[i] / cellSize_;
+        cellY_[i] = ys[i] / cellSize_;
+        ++bucketStart_[bucketOf(cellX_[i], cellY_[i]) + 1];
+    }
+    for (size_t b = 0; b < buckets; ++b) {
+        bucketStart_[b + 1] += bucketStart_[b];
+    }
+    for (size_t i = 0; i < count; ++i) {
+        size_t bucket = bucketOf(cellX_[i], cellY_[i]);
+        // bucketStart_[bucket] is used as the insertion cursor and restored below
+        uint32_t slot = bucketStart_[bucket]++;
+        sorted_[slot] = static_cast<uint32_t>(i);
+        sortedX_[slot] = xs[i];
+        sortedY_[slot] = ys[i];
+        sortedRange_[slot] = ranges[i];
+    }
+    for (size_t b = buckets; b > 0; --b) {
+        bucketStart_[b] = bucketStart_[b - 1];
+    }
+    bucketStart_[0] = 0;
+}
+
+void SpatialGrid::findPairs(const int* xs, const int* ys, const int* ranges,
+                            size_t begin, size_t end, std::vector<Pair>& out) const {
+    for (size_t a = begin; a < end; ++a) {
+        size_t first = out.size();
+        int cx = cellX_[a];
+        int cy = cellY_[a];
+
+        for (int ny = cy - 1; ny <= cy + 1; ++ny) {
+            for (int nx = cx - 1; nx <= cx + 1; ++nx) {
+                if (nx < 0 || ny < 0) continue;
+
+                size_t bucket = bucketOf(nx, ny);
+                uint32_t stop = bucketStart_[bucket + 1];
+                for (uint32_t base = bucketStart_[bucket]; base < stop; base += 64) {
+                    size_t run = std::min<size_t>(64, stop - base);
+                    uint64_t hits = rangeMask(xs[a], ys[a], ranges[a], sortedX_.data() + base,
+                                              sortedY_.data() + base, sortedRange_.data() + base, run);
+
+                    for (; hits != 0; hits &= hits - 1) {
+                        uint32_t b = sorted_[base + __builtin_ctzll(hits)];
+                        if (b <= a) continue;
+                        // Buckets are shared between colliding cells; keep only this cell
+                        if (cellX_[b] != nx || cellY_[b] != ny) continue;
+                        out.emplace_back(static_cast<uint32_t>(a), b);
+                    }
+                }
+            }
+        }
+
+        // Neighbour cells are visited out of index order; restore (a, b) ordering
+        std::sort(out.begin() + first, out.end());
+    }
+}
+
+size_t SpatialGrid::bucketOf(int cx, int cy) const {
+    uint64_t h = static_cast<uint64_t>(static_cast<uint32_t>(cx)) * 73856093u
+               ^ static_cast<uint64_t>(static_cast<uint32_t>(cy)) * 19349663u;
+    return static_cast<size_t>(h) & mask_;
+}
@@ -1,4 +0,0 @@
-#include "../include/squirrel.h"
-
-Squirrel::Squirrel(const std::string& name, int x, int y)
-    : NPC(Type::Squirrel, name, x, y) {}
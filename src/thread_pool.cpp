@@ -0,0 +1,149 @@
+#include "../include/thread_pool.h"
+#include <algorithm>
+
+ThreadPool::ThreadPool(unsigned threads) {
+    if (threads == 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    
+    queues_ = std::vector<Queue>(threads);
+    for (unsigned w = 1; w < threads; ++w) {
+        workers_.emplace_back(&ThreadPool::workerLoop, this, w);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(wakeMutex_);
+        stop_ = true;
+    }
+    wakeCV_.notify_all();
+    
+    for (auto& worker : workers_) {
+        if (worker.joinable()) worker.join();
+    }
+}
+
+void ThreadPool::run(size_t begin, size_t end, size_t grain, ChunkFn fn, void* ctx) {
+    if (begin >= end) return;
+    grain = std::max<size_t>(1, grain);
+    
+    size_t chunks = (end - begin + grain - 1) / grain;
+    if (queues_.size() == 1 || chunks == 1) {
+        fn(ctx, begin, end, 0);
+        return;
+    }
+    
+    std::lock_guard<std::mutex> callLock(callMutex_);
+    
+    fn_ = fn;
+    ctx_ = ctx;
+    begin_ = begin;
+    end_ = end;
+    grain_ = grain;
+    pending_.store(chunks, std::memory_order_relaxed);
+    
+    // Deal chunks out evenly; stealing evens out chunks of uneven cost
+    size_t workers = queues_.size();
+    for (size_t w = 0; w < workers; ++w) {
+        auto front = static_cast<uint32_t>(chunks * w / workers);
+        auto back = static_cast<uint32_t>(chunks * (w + 1) / workers);
+        queues_[w].range.store(packRange(front, back), std::memory_order_release);
+    }
+    
+    {
+        std::lock_guard<std::mutex> lock(wakeMutex_);
+        ++generation_;
+    }
+    wakeCV_.notify_all();
+    
+    work(0);
+    
+    // Barrier: wait for chunks still running on other workers
+    while (pending_.load(std::memory_order_acquire) != 0) {
+        std::this_thread::yield();
+    }
+}
+
+void ThreadPool::workerLoop(unsigned worker) {
+    uint64_t seen = 0;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(wakeMutex_);
+            wakeCV_.wait(lock, [&] { return stop_ || generation_ != seen; });
+            if (stop_) return;
+            seen = generation_;
+        }
+        work(worker);
+    }
+}
+
+void ThreadPool::work(unsigned worker) {
+    uint32_t chunk;
+    do {
+        while (popChunk(worker, chunk)) {
+            runChunk(chunk, worker);
+        }
+    } while (steal(worker));
+}
+
+bool ThreadPool::popChunk(unsigned worker, uint32_t& chunk) {
+    auto& range = queues_[worker].range;
+    uint64_t current = range.load(std::memory_order_acquire);
+    while (true) {
+        auto front = static_cast<uint32_t>(current);
+        auto back = static_cast<uint32_t>(current >> 32);
+        if (front >= back) return false;
+        
+        if (range.compare_exchange_weak(current, packRange(front + 1, back),
+                                        std::memory_order_acq_rel)) {
+            chunk = front;
+            return true;
+        }
+    }
+}
+
+bool ThreadPool::steal(unsigned thief) {
+    // A thief can still be here from the previous job when run() deals it a
+    // range for the next one, so the stolen half only replaces the empty
+    // range seen now, never a freshly dealt one
+    auto& own = queues_[thief].range;
+    uint64_t empty = own.load(std::memory_order_acquire);
+    if (static_cast<uint32_t>(empty) < static_cast<uint32_t>(empty >> 32)) return true;
+    
+    size_t workers = queues_.size();
+    for (size_t offset = 1; offset < workers; ++offset) {
+        auto& victim = queues_[(thief + offset) % workers].range;
+        uint64_t current = victim.load(std::memory_order_acquire);
+        
+        while (true) {
+            auto front = static_cast<uint32_t>(current);
+            auto back = static_cast<uint32_t>(current >> 32);
+            if (front >= back) break;
+            
+            // Take the back half, rounding up so a single chunk can be stolen
+            uint32_t mid = front + (back - front) / 2;
+            if (victim.compare_exchange_weak(current, packRange(front, mid),
+                                             std::memory_order_acq_rel)) {
+                if (!own.compare_exchange_strong(empty, packRange(mid, back),
+                                                 std::memory_order_acq_rel)) {
+                    // run() dealt a new job meanwhile; it only does that once
+                    // every chunk of the last one has run, so the stolen
+                    // chunks belong to the new job too. Run them here.
+                    for (uint32_t chunk = mid; chunk < back; ++chunk) {
+                        runChunk(chunk, thief);
+                    }
+                }
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+void ThreadPool::runChunk(uint32_t chunk, unsigned worker) {
+    size_t b = begin_ + static_cast<size_t>(chunk) * grain_;
+    size_t e = std::min(end_, b + grain_);
+    fn_(ctx_, b, e, worker);
+    pending_.fetch_sub(1, std::memory_order_acq_rel);
+}
@@ -0,0 +1,143 @@
+#include "../include/world.h"
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+
+void World::reserve(size_t capacity) {
+    if (capacity <= capacity_) return;
+
+    auto positions = std::make_unique<std::atomic<uint64_t>[]>(capacity);
+    auto alive = std::make_unique<std::atomic<uint8_t>[]>(capacity);
+    auto types = std::make_unique<NPC::Type[]>(capacity);
+    auto ordinals = std::make_unique<uint32_t[]>(capacity);
+    auto names = std::make_unique<std::atomic<const char*>[]>(capacity);
+
+    for (size_t i = 0; i < size_; ++i) {
+        positions[i].store(positions_[i].load(std::memory_order_relaxed), std::memory_order_relaxed);
+        alive[i].store(alive_[i].load(std::memory_order_relaxed), std::memory_order_relaxed);
+        names[i].store(names_[i].load(std::memory_order_relaxed), std::memory_order_relaxed);
+    }
+    std::copy(types_.get(), types_.get() + size_, types.get());
+    std::copy(ordinals_.get(), ordinals_.get() + size_, ordinals.get());
+
+    positions_ = std::move(positions);
+    alive_ = std::move(alive);
+    types_ = std::move(types);
+    ordinals_ = std::move(ordinals);
+    names_ = std::move(names);
+    capacity_ = capacity;
+}
+
+World::Index World::add(NPC::Type type, int x, int y) {
+    if (size_ == capacity_) {
+        reserve(std::max<size_t>(16, capacity_ * 2));
+    }
+
+    Index i = static_cast<Index>(size_++);
+    positions_[i].store(pack(x, y), std::memory_order_relaxed);
+    alive_[i].store(1, std::memory_order_relaxed);
+    names_[i].store(nullptr, std::memory_order_relaxed);
+    types_[i] = type;
+    active_.push_back(i);
+    typeIndices_[static_cast<size_t>(type)].push_back(i);
+    ordinals_[i] = ++typeCounts_[static_cast<size_t>(type)];
+    aliveByType_[static_cast<size_t>(type)].fetch_add(1, std::memory_order_relaxed);
+    return i;
+}
+
+void World::resize(size_t count) {
+    if (count <= size_) return;
+    reserve(count);
+    size_ = count;
+}
+
+void World::reindex() {
+    active_.clear();
+    for (auto& indices : typeIndices_) indices.clear();
+    typeCounts_.fill(0);
+
+    // Ordinals count every NPC, dead or alive, so names match the original run
+    for (Index i = 0; i < size_; ++i) {
+        auto type = static_cast<size_t>(types_[i]);
+        ordinals_[i] = ++typeCounts_[type];
+        if (!alive_[i].load(std::memory_order_relaxed)) continue;
+        active_.push_back(i);
+        typeIndices_[type].push_back(i);
+    }
+    for (size_t t = 0; t < NPC::kTypeCount; ++t) {
+        aliveByType_[t].store(static_cast<uint32_t>(typeIndices_[t].size()), std::memory_order_relaxed);
+    }
+    pendingDead_.store(0, std::memory_order_relaxed);
+}
+
+void World::clear() {
+    size_ = 0;
+    active_.clear();
+    for (auto& indices : typeIndices_) indices.clear();
+    typeCounts_.fill(0);
+    for (auto& alive : aliveByType_) alive.store(0, std::memory_order_relaxed);
+    pendingDead_.store(0, std::memory_order_relaxed);
+    // Name blocks are kept and refilled from the start
+    nameBlock_ = 0;
+    nameUsed_ = 0;
+}
+
+void World::compact() {
+    // Alive flags are sampled once; the per-type lists are rebuilt from the
+    // result so both always hold the same NPCs
+    auto kept = std::remove_if(active_.begin(), active_.end(),
+                               [this](Index i) { return !isAlive(i); });
+    auto removed = static_cast<int64_t>(active_.end() - kept);
+    active_.erase(kept, active_.end());
+
+    for (auto& indices : typeIndices_) indices.clear();
+    for (Index i : active_) {
+        typeIndices_[static_cast<size_t>(types_[i])].push_back(i);
+    }
+    pendingDead_.fetch_sub(removed, std::memory_order_relaxed);
+}
+
+const char* World::internName(Index i) const {
+    std::lock_guard<std::mutex> lock(nameMutex_);
+    // Another reader may have interned it while we waited
+    const char* entry = names_[i].load(std::memory_order_relaxed);
+    if (entry != nullptr) return entry;
+
+    char buffer[64];
+    std::string_view type = NPC::typeToString(types_[i]);
+    std::memcpy(buffer, type.data(), type.size());
+    char* end = buffer + type.size();
+    *end++ = '_';
+    end = std::to_chars(end, buffer + sizeof(buffer), ordinals_[i]).ptr;
+    size_t length = static_cast<size_t>(end - buffer);
+
+    if (nameBlocks_.empty() || nameUsed_ + length + 1 > kNameBlockSize) {
+        if (!nameBlocks_.empty()) ++nameBlock_;
+        if (nameBlock_ == nameBlocks_.size()) {
+            nameBlocks_.push_back(std::make_unique<char[]>(kNameBlockSize));
+        }
+        nameUsed_ = 0;
+    }
+
+    char* slot = nameBlocks_[nameBlock_].get() + nameUsed_;
+    slot[0] = static_cast<char>(length);
+    std::memcpy(slot + 1, buffer, length);
+    nameUsed_ += length + 1;
+
+    names_[i].store(slot, std::memory_order_release);
+    return slot;
+}
+
+NPCPtr World::npc(Index i) {
+    return makeHandle(types_[i], i);
+}
+
+NPCPtr World::makeHandle(NPC::Type type, Index i) {
+    NPCPtr handle;
+    forEachNPCType([&](auto tag) {
+        if (decltype(tag)::value == type) {
+            handle = std::make_shared<TypedNPC<decltype(tag)::value>>(*this, i);
+        }
+    });
+    return handle;
+}
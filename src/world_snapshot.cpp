@@ -0,0 +1,18 @@
+#include "../include/world_snapshot.h"
+
+void WorldSnapshot::capture(const World& world, uint64_t captureTick, int captureMapSize) {
+    tick = captureTick;
+    mapSize = captureMapSize;
+    total = world.size();
+
+    positions.clear();
+    types.clear();
+    indices.clear();
+
+    for (World::Index i : world.active()) {
+        if (!world.isAlive(i)) continue;
+        positions.push_back(world.packedPosition(i));
+        types.push_back(world.type(i));
+        indices.push_back(i);
+    }
+}
@@ -0,0 +1,127 @@
+#include "../include/combat_queue.h"
+#include <algorithm>
+#include <atomic>
+#include <iostream>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// CombatQueue: batch push/pop at the capacity limits, then an MPMC stress
+// run on a small ring (so it wraps and fills constantly) with several
+// producers and consumers. Every event must come out exactly once, ring
+// positions must be dense, and each producer's events must keep their
+// order; consumers sleeping in wait() must wake for new events and on close.
+
+namespace {
+
+int failures = 0;
+
+void check(bool ok, const char* what) {
+    if (ok) return;
+    ++failures;
+    std::cout << "FAIL " << what << "\n";
+}
+
+void capacityLimits() {
+    CombatQueue queue(6);
+    check(queue.capacity() == 8, "capacity rounds up to a power of two");
+
+    CombatEvent in[10];
+    for (uint32_t i = 0; i < 10; ++i) in[i] = {i, i + 100};
+
+    size_t position = 99;
+    check(queue.pushBatch(in, 10, &position) == 8, "push stops when full");
+    check(position == 0 && queue.size() == 8, "first position and depth");
+    check(queue.pushBatch(in, 1) == 0, "push to a full ring");
+
+    CombatEvent out[10];
+    check(queue.popBatch(out, 3, &position) == 3 && position == 0, "partial pop");
+    check(out[0].attacker == 0 && out[2].defender == 102, "pop order");
+    check(queue.pushBatch(in + 8, 2, &position) == 2 && position == 8, "push after wrapping");
+
+    check(queue.popBatch(out, 10, &position) == 7 && position == 3, "drain");
+    check(out[4].attacker == 7 && out[5].attacker == 8 && out[6].attacker == 9, "order across the wrap");
+    check(queue.empty() && queue.popBatch(out, 1) == 0, "empty after drain");
+}
+
+// Event payload: producer in the attacker field, its sequence in the defender
+void multiProducerMultiConsumer() {
+    const uint32_t producers = 4;
+    const uint32_t consumers = 3;
+    const uint32_t perProducer = 1000000;
+
+    CombatQueue queue(64);
+    std::vector<std::vector<std::pair<size_t, CombatEvent>>> received(consumers);
+    std::vector<std::thread> threads;
+
+    for (uint32_t c = 0; c < consumers; ++c) {
+        threads.emplace_back([&, c] {
+            CombatEvent batch[16];
+            size_t maxCount = 1 + c * 7;
+            while (true) {
+                size_t position = 0;
+                size_t count = queue.popBatch(batch, maxCount, &position);
+                if (count == 0) {
+                    if (!queue.wait()) break;
+                    continue;
+                }
+                for (size_t i = 0; i < count; ++i) received[c].push_back({position + i, batch[i]});
+            }
+        });
+    }
+
+    std::vector<std::thread> producerThreads;
+    for (uint32_t p = 0; p < producers; ++p) {
+        producerThreads.emplace_back([&, p] {
+            CombatEvent batch[32];
+            uint32_t sent = 0;
+            while (sent < perProducer) {
+                size_t count = std::min<uint32_t>(1 + (sent + p) % 32, perProducer - sent);
+                for (size_t i = 0; i < count; ++i) batch[i] = {p, sent + static_cast<uint32_t>(i)};
+
+                // A short push publishes a prefix; the rest is retried
+                size_t pushed = queue.pushBatch(batch, count);
+                sent += static_cast<uint32_t>(pushed);
+                if (pushed == 0) std::this_thread::yield();
+            }
+        });
+    }
+    for (auto& thread : producerThreads) thread.join();
+
+    // Let the consumers drain before closing; wait() still returns true
+    // while events remain
+    while (!queue.empty()) std::this_thread::yield();
+    queue.close();
+    for (auto& thread : threads) thread.join();
+
+    std::vector<std::pair<size_t, CombatEvent>> all;
+    for (const auto& part : received) all.insert(all.end(), part.begin(), part.end());
+    std::sort(all.begin(), all.end(),
+              [](const auto& a, const auto& b) { return a.first < b.first; });
+
+    check(all.size() == size_t{producers} * perProducer, "every event popped once");
+    bool dense = true;
+    bool ordered = true;
+    std::vector<uint32_t> next(producers, 0);
+    for (size_t i = 0; i < all.size(); ++i) {
+        if (all[i].first != i) dense = false;
+        const CombatEvent& event = all[i].second;
+        if (event.attacker >= producers || event.defender != next[event.attacker]) {
+            ordered = false;
+            continue;
+        }
+        ++next[event.attacker];
+    }
+    check(dense, "ring positions are dense and unique");
+    check(ordered, "each producer's events keep their order");
+}
+
+} // namespace
+
+int main() {
+    capacityLimits();
+    multiProducerMultiConsumer();
+
+    std::cout << failures << " failures\n";
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,114 @@
+#include "../include/pair_set.h"
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+// PairSet erase uses backward-shift deletion, which must keep every other
+// key of a probe cluster reachable, including clusters that wrap past the
+// end of the table. Targeted wrap-around cases come first, then a long
+// random insert/erase/find run against std::unordered_map.
+
+namespace {
+
+int failures = 0;
+
+void check(bool ok, const char* what) {
+    if (ok) return;
+    ++failures;
+    std::cout << "FAIL " << what << "\n";
+}
+
+// Same Fibonacci hash as PairSet::homeOf, to pick keys by home slot
+size_t homeSlot(uint64_t key, size_t capacity) {
+    return static_cast<size_t>((key * 0x9E3779B97F4A7C15ull) >> 20) & (capacity - 1);
+}
+
+// Keys whose home slots are near the end of a 64-slot table, so their
+// probe runs wrap to the front, plus keys homed at the front that the
+// wrapped entries displace
+std::vector<uint64_t> wrappingKeys() {
+    std::vector<uint64_t> keys;
+    size_t perHome[64] = {};
+    for (uint32_t a = 0; keys.size() < 16 && a < 100000; ++a) {
+        uint64_t key = PairSet::key(a, a + 1);
+        size_t home = homeSlot(key, 64);
+        bool wanted = home >= 60 || home <= 1;
+        if (wanted && perHome[home] < 3) {
+            ++perHome[home];
+            keys.push_back(key);
+        }
+    }
+    return keys;
+}
+
+void wrapAroundClusters() {
+    std::vector<uint64_t> keys = wrappingKeys();
+    check(keys.size() == 16, "found wrapping keys");
+
+    // Erase each key in turn from a full cluster, in several orders
+    for (size_t rotation = 0; rotation < keys.size(); ++rotation) {
+        for (bool reverse : {false, true}) {
+            PairSet set;
+            for (size_t i = 0; i < keys.size(); ++i) set.insert(keys[i], i);
+            check(set.capacity() == 64, "table stays at 64 slots");
+
+            for (size_t n = 0; n < keys.size(); ++n) {
+                size_t victim = (rotation + (reverse ? keys.size() - n : n)) % keys.size();
+                check(set.erase(keys[victim]), "erase present key");
+                check(!set.erase(keys[victim]), "erase absent key");
+                check(!set.contains(keys[victim]), "erased key gone");
+                check(set.size() == keys.size() - n - 1, "size after erase");
+
+                // Everything not yet erased is still found with its value
+                for (size_t m = n + 1; m < keys.size(); ++m) {
+                    size_t other = (rotation + (reverse ? keys.size() - m : m)) % keys.size();
+                    const uint64_t* value = set.find(keys[other]);
+                    check(value && *value == other, "survivor still reachable");
+                }
+            }
+        }
+    }
+}
+
+void randomAgainstReference() {
+    std::mt19937_64 rng(7);
+    PairSet set;
+    std::unordered_map<uint64_t, uint64_t> reference;
+
+    for (int step = 0; step < 1000000; ++step) {
+        // A small key space keeps clusters long and collisions frequent
+        uint64_t key = PairSet::key(static_cast<uint32_t>(rng() % 200), static_cast<uint32_t>(rng() % 200));
+        switch (rng() % 3) {
+            case 0:
+                check(set.insert(key, step) == reference.emplace(key, step).second, "insert matches");
+                break;
+            case 1:
+                check(set.erase(key) == (reference.erase(key) == 1), "erase matches");
+                break;
+            default: {
+                const uint64_t* value = set.find(key);
+                auto it = reference.find(key);
+                check((value != nullptr) == (it != reference.end()) && (!value || *value == it->second),
+                      "find matches");
+            }
+        }
+        check(set.size() == reference.size(), "size matches");
+        if (step % 50000 == 0) {
+            set.clear();
+            reference.clear();
+        }
+        if (failures > 10) return;
+    }
+}
+
+} // namespace
+
+int main() {
+    wrapAroundClusters();
+    randomAgainstReference();
+
+    std::cout << failures << " failures\n";
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,120 @@
+#include "../include/scheduler.h"
+#include <chrono>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+// Scheduler: tasks fire at their own periods and, when due in the same
+// slot, in the order they were added; a task that overruns skips its
+// missed runs instead of firing them back-to-back; stop() wakes run() at
+// once however far off the next task is, and reset() allows another run.
+// Timing bounds are loose so a loaded machine does not fail the test.
+
+namespace {
+
+using Clock = Scheduler::Clock;
+using std::chrono::milliseconds;
+
+int failures = 0;
+
+void check(bool ok, const char* what) {
+    if (ok) return;
+    ++failures;
+    std::cout << "FAIL " << what << "\n";
+}
+
+// Runs the scheduler on its own thread for about `length`, then stops it
+void runFor(Scheduler& scheduler, Clock::duration length) {
+    std::thread thread(&Scheduler::run, &scheduler);
+    std::this_thread::sleep_for(length);
+    scheduler.stop();
+    thread.join();
+}
+
+void periods() {
+    Scheduler scheduler(milliseconds(1));
+    int fast = 0;
+    int slow = 0;
+    scheduler.every(milliseconds(10), [&] { ++fast; });
+    scheduler.every(milliseconds(25), [&] { ++slow; });
+
+    auto start = Clock::now();
+    runFor(scheduler, milliseconds(500));
+    auto elapsed = std::chrono::duration_cast<milliseconds>(Clock::now() - start).count();
+
+    // Never more than one run per period; a busy machine may give fewer
+    check(fast >= 10 && fast <= elapsed / 10, "10 ms task count");
+    check(slow >= 4 && slow <= elapsed / 25, "25 ms task count");
+    check(fast > slow, "shorter period runs more often");
+}
+
+void sameSlotOrder() {
+    Scheduler scheduler(milliseconds(1));
+    std::vector<int> order;
+    // Equal periods keep the three in the same slot, even after a late run
+    for (int task = 0; task < 3; ++task) {
+        scheduler.every(milliseconds(10), [&, task] { order.push_back(task); });
+    }
+    // Shares their slot of the 256-slot wheel but is due a turn later, so
+    // picking the due tasks out of the slot moves them around
+    scheduler.every(milliseconds(10 + 256), [&] { order.push_back(3); });
+    runFor(scheduler, milliseconds(200));
+
+    bool ordered = order.size() % 3 == 0;
+    for (size_t i = 0; i < order.size(); ++i) {
+        if (order[i] != static_cast<int>(i % 3)) ordered = false;
+    }
+    check(order.size() >= 9, "same-slot tasks ran");
+    check(ordered, "same-slot tasks run in the order added");
+}
+
+void missedRunsSkipped() {
+    Scheduler scheduler(milliseconds(1));
+    std::vector<Clock::time_point> runs;
+    scheduler.every(milliseconds(10), [&] {
+        runs.push_back(Clock::now());
+        // The first run overruns five periods
+        if (runs.size() == 1) std::this_thread::sleep_for(milliseconds(55));
+    });
+    runFor(scheduler, milliseconds(200));
+
+    check(runs.size() >= 3, "task kept running after an overrun");
+    if (runs.size() < 3) return;
+    // A burst of catch-up runs would start within a slot or two of each
+    // other; after a skip the next one is a whole period out
+    check(runs[2] - runs[1] >= milliseconds(5), "missed runs skipped, not burst");
+}
+
+void stopWakesAtOnce() {
+    Scheduler scheduler;
+    int runs = 0;
+    scheduler.every(std::chrono::seconds(30), [&] { ++runs; });
+
+    auto start = Clock::now();
+    runFor(scheduler, milliseconds(20));
+    check(Clock::now() - start < std::chrono::seconds(5), "stop wakes a sleeping run");
+    check(runs == 0, "no task ran before its period");
+
+    // stop() before run() returns at once too, until reset() clears it
+    scheduler.stop();
+    start = Clock::now();
+    scheduler.run();
+    check(Clock::now() - start < std::chrono::seconds(5), "run returns after an earlier stop");
+
+    scheduler.reset();
+    scheduler.every(milliseconds(10), [&] { ++runs; });
+    runFor(scheduler, milliseconds(100));
+    check(runs > 0, "reset clears the stop");
+}
+
+} // namespace
+
+int main() {
+    periods();
+    sameSlotOrder();
+    missedRunsSkipped();
+    stopWakesAtOnce();
+
+    std::cout << failures << " failures\n";
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,109 @@
+#include "../include/snapshot_exchange.h"
+#include <atomic>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+// SnapshotExchange must never stall the publisher, however many readers
+// hold pins: with more long-lived readers than the initial slots, publish
+// grows the slot array; once every one of kMaxSlots is pinned it skips.
+// Concurrent readers must always see one whole, unchanging tick.
+
+namespace {
+
+int failures = 0;
+
+void check(bool ok, const char* what) {
+    if (ok) return;
+    ++failures;
+    std::cout << "FAIL " << what << "\n";
+}
+
+// World whose NPC i sits at (tick, i), so a snapshot names its own tick
+void fill(World& world, uint64_t tick) {
+    const size_t count = 64;
+    world.clear();
+    world.resize(count);
+    for (size_t i = 0; i < count; ++i) {
+        world.place(static_cast<World::Index>(i), NPC::Type::Knight,
+                    World::pack(static_cast<int>(tick % 1000), static_cast<int>(i)), true);
+    }
+    world.reindex();
+}
+
+bool consistent(const WorldSnapshot& snapshot) {
+    for (size_t i = 0; i < snapshot.alive(); ++i) {
+        int x, y;
+        World::unpack(snapshot.positions[i], x, y);
+        if (static_cast<uint64_t>(x) != snapshot.tick % 1000 || y != static_cast<int>(i)) return false;
+    }
+    return snapshot.alive() == 64;
+}
+
+void pinnedReaders() {
+    SnapshotExchange exchange;
+    World world;
+    std::vector<SnapshotExchange::Reader> pins;
+
+    // Each reader keeps its tick; every publish must still go through
+    uint64_t tick = 1;
+    for (; tick <= SnapshotExchange::kMaxSlots; ++tick) {
+        fill(world, tick);
+        check(exchange.publish(world, tick, 1000), "publish with a free or new slot");
+        pins.push_back(exchange.acquire());
+        check(pins.back()->tick == tick, "reader sees the latest tick");
+    }
+    check(exchange.slotCount() == SnapshotExchange::kMaxSlots, "slots grew to the maximum");
+    for (const auto& pin : pins) check(consistent(*pin), "pinned snapshot unchanged");
+
+    // All kMaxSlots pinned: the publish is skipped, not waited out
+    fill(world, tick);
+    check(!exchange.publish(world, tick, 1000), "publish skipped with every slot pinned");
+    check(exchange.skipped() == 1, "skip counted");
+    check(exchange.acquire()->tick == tick - 1, "readers keep the previous tick");
+
+    // Releasing one pin frees a slot again
+    pins.erase(pins.begin());
+    check(exchange.publish(world, tick, 1000), "publish after a release");
+    check(exchange.acquire()->tick == tick, "latest tick after a release");
+}
+
+void concurrentReaders() {
+    SnapshotExchange exchange;
+    World world;
+    std::atomic<bool> done{false};
+    std::atomic<int> torn{0};
+    std::vector<std::thread> readers;
+
+    for (int r = 0; r < 8; ++r) {
+        readers.emplace_back([&] {
+            std::vector<SnapshotExchange::Reader> held;
+            while (!done.load(std::memory_order_relaxed)) {
+                auto reader = exchange.acquire();
+                if (reader && !consistent(*reader)) torn.fetch_add(1);
+                // Hold a few pins at a time to push the writer past its spare slots
+                held.push_back(std::move(reader));
+                if (held.size() > 3) held.erase(held.begin());
+            }
+        });
+    }
+    for (uint64_t tick = 1; tick <= 20000; ++tick) {
+        fill(world, tick);
+        exchange.publish(world, tick, 1000);
+    }
+    done = true;
+    for (auto& reader : readers) reader.join();
+
+    check(torn.load() == 0, "readers never see a snapshot being refilled");
+    check(exchange.published() + exchange.skipped() == 20000, "every publish returned");
+}
+
+} // namespace
+
+int main() {
+    pinnedReaders();
+    concurrentReaders();
+
+    std::cout << failures << " failures\n";
+    return failures == 0 ? 0 : 1;
+}
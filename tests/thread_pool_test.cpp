@@ -0,0 +1,76 @@
+#include "../include/thread_pool.h"
+#include <atomic>
+#include <iostream>
+#include <vector>
+
+// Stress test for ThreadPool::parallelFor: many back-to-back jobs with
+// uneven chunk costs, so thieves from one job are still stealing when the
+// next one is dealt out. Every index must run exactly once, within its own
+// job's range; a chunk lost to a late steal shows up as a hang (ctest
+// times the test out) or as a missed index.
+
+namespace {
+
+const int kJobs = 50000;
+const size_t kMaxItems = 512;
+
+// Cheap deterministic hash for uneven per-item cost
+uint32_t mix(uint32_t x) {
+    x ^= x >> 16;
+    x *= 0x7feb352dU;
+    x ^= x >> 15;
+    return x;
+}
+
+volatile uint32_t sink = 0;
+
+} // namespace
+
+int main() {
+    ThreadPool pool(8);
+    std::vector<std::atomic<int>> visits(kMaxItems);
+    std::atomic<int> strays{0};
+    int failures = 0;
+
+    for (int job = 0; job < kJobs; ++job) {
+        // Runs of jobs share a shape, so a thief's stale view of a victim's
+        // range can match the next job's range exactly
+        uint32_t shape = mix(static_cast<uint32_t>(job / 4));
+        size_t begin = shape % 7;
+        size_t end = begin + 2 + (shape >> 8) % (kMaxItems - 8);
+        size_t grain = 1 + (shape >> 20) % 4;
+        for (auto& count : visits) count.store(0, std::memory_order_relaxed);
+
+        pool.parallelFor(begin, end, grain, [&](size_t b, size_t e, unsigned) {
+            for (size_t i = b; i < e; ++i) {
+                // A few items are far more expensive than the rest
+                uint32_t spins = mix(static_cast<uint32_t>(job * 977 + i)) % 64 == 0 ? 20000 : 50;
+                uint32_t value = 0;
+                for (uint32_t s = 0; s < spins; ++s) value += mix(s);
+                sink = value;
+
+                if (i < begin || i >= end || i >= kMaxItems) {
+                    strays.fetch_add(1, std::memory_order_relaxed);
+                    continue;
+                }
+                visits[i].fetch_add(1, std::memory_order_relaxed);
+            }
+        });
+
+        for (size_t i = 0; i < kMaxItems; ++i) {
+            int expected = i >= begin && i < end ? 1 : 0;
+            int seen = visits[i].load(std::memory_order_relaxed);
+            if (seen == expected) continue;
+
+            ++failures;
+            if (failures <= 10) {
+                std::cout << "FAIL job " << job << " index " << i << " ran " << seen << " times\n";
+            }
+        }
+    }
+
+    // Indices outside the job's range: chunks run against another job
+    failures += strays.load();
+    std::cout << kJobs << " jobs, " << failures << " failures\n";
+    return failures == 0 ? 0 : 1;
+}